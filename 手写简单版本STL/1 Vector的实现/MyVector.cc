@@ -1,13 +1,19 @@
 #include <iostream>
 #include <string>
-#include <stdexcept> //out_of_range类
-#include <sstream>   //isstring stream
+#include <stdexcept>   //out_of_range类
+#include <sstream>     //isstring stream
+#include <new>         //operator new / placement new
+#include <memory>      //uninitialized_copy
+#include <utility>     //move、forward、move_if_noexcept、swap
+#include <type_traits> //is_trivially_copyable等类型萃取
+#include <algorithm>   //move_backward
+#include <cstring>     //memcpy
 
 template <typename T>
 class Vector
 {
 private:
-    T *elements;     // 指向动态数组的指针
+    T *elements;     // 指向动态数组的指针（只有前size个位置上构造了元素，后面是未初始化的内存）
     size_t capacity; // 数组的容量
     size_t size;     // 数组中的元素个数
 public:
@@ -22,49 +28,131 @@ public:
     // 析构函数
     ~Vector()
     {
-        delete[] elements; // 释放 elements 指向的动态分配的内存
+        clear();                          // 先逐个析构已经构造的元素
+        deallocate(elements, capacity);   // 再释放原始内存
     }
 
     // 拷贝构造函数
-    Vector(const Vector &other) : capacity(other.capacity),
+    Vector(const Vector &other) : elements(allocate(other.size)),
+                                  capacity(other.size),
                                   size(other.size)
     {
-        // 深拷贝
-        elements = new T[capacity];
-        std::copy(other.elements, other.elements + size, elements);
+        // 深拷贝：在未初始化的内存上逐个拷贝构造（中途抛异常时uninitialized_copy会析构已构造的元素）
+        try
+        {
+            std::uninitialized_copy(other.elements, other.elements + size, elements);
+        }
+        catch (...)
+        {
+            deallocate(elements, capacity);
+            throw;
+        }
     }
     /*
         first: 复制的源序列的起始位置（包含）
         last: 要复制的源序列的结束位置（不包含，即 [first, last)）
-        d_first: 目标范围的起始位置
+        d_first: 目标范围的起始位置（必须是未初始化的内存，std::copy要求目标位置上已经有构造好的对象）
     */
 
+    // 移动构造函数：直接接管other的内存，other变为空数组
+    Vector(Vector &&other) noexcept : elements(other.elements),
+                                      capacity(other.capacity),
+                                      size(other.size)
+    {
+        other.elements = nullptr;
+        other.capacity = 0;
+        other.size = 0;
+    }
+
     // 拷贝赋值操作符
     Vector &operator=(const Vector &other)
     {
-        // 检查自赋值的情况。如果不是可以释放当前对象内存；如果是直接返回当前对象
+        // 检查自赋值的情况。先拷贝出一个临时对象再交换：拷贝中途抛异常时当前对象不受影响
+        if (this != &other)
+        {
+            Vector copy(other);
+            swap(copy);
+        } // copy析构时释放原来的内存
+        return *this;
+    }
+
+    // 移动赋值操作符
+    Vector &operator=(Vector &&other) noexcept
+    {
         if (this != &other)
         {
-            delete[] elements;
+            clear();
+            deallocate(elements, capacity);
+            elements = other.elements;
             capacity = other.capacity;
             size = other.size;
-            elements = new T[capacity];
-            std::copy(other.elements, other.elements + size, elements); // 深拷贝
+            other.elements = nullptr;
+            other.capacity = 0;
+            other.size = 0;
         }
         return *this;
     }
 
+    // 交换两个数组的内容（只交换指针和计数）
+    void swap(Vector &other) noexcept
+    {
+        std::swap(elements, other.elements);
+        std::swap(capacity, other.capacity);
+        std::swap(size, other.size);
+    }
+
     // 2.核心功能
     //  添加元素到数组末尾
     void push_back(const T &value)
     {
-        if (size == capacity)
+        emplace_back(value);
+    }
+
+    // 添加元素到数组末尾（右值版本：移动而不是拷贝）
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    // 用参数args直接在数组末尾构造元素，返回新元素的引用
+    template <typename... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size < capacity)
+        {
+            new (elements + size) T(std::forward<Args>(args)...); // placement new：在已分配的内存上构造
+            return elements[size++];
+        }
+        // 数组已满，扩展容量
+        /*
+            先在新内存上构造新元素，再搬运旧元素：args可能引用的是数组中已有的元素（例如v.push_back(v[0])），
+            如果先搬运旧元素，args引用的对象已经被移走或析构了。
+        */
+        size_t newCapacity = (capacity == 0 ? 1 : 2 * capacity);
+        T *newElements = allocate(newCapacity);
+        try
+        {
+            new (newElements + size) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            deallocate(newElements, newCapacity);
+            throw;
+        }
+        try
+        {
+            relocate(elements, size, newElements);
+        }
+        catch (...)
         {
-            // 如果数组已满，扩展容量
-            reserve(capacity == 0 ? 1 : 2 * capacity); // reserve申请内存 -> 复制元素 -> 释放旧内存
+            newElements[size].~T();
+            deallocate(newElements, newCapacity);
+            throw;
         }
-        // reserve把成员变量 elements 赋值为新地址 （自定义实现reserve函数）
-        elements[size++] = value;
+        deallocate(elements, capacity);
+        elements = newElements;
+        capacity = newCapacity;
+        return elements[size++];
     }
 
     // 获取数组中元素的个数
@@ -110,19 +198,23 @@ public:
         {
             throw std::out_of_range("Index out of range");
         }
-        if (size == capacity)
+        if (index == size)
         {
-            reserve(capacity == 0 ? 1 : capacity * 2);
+            emplace_back(value);
+            return;
         }
-        for (size_t i = size; i > index; i--)
+        T copy(value); // value可能是数组中的元素，后移元素之前先拷贝出来
+        if (size == capacity)
         {
-            // 如果扩容,此时elements已经指向新的内存
-            // 将当前索引及之后的元素向后移动一个位置
-            elements[i] = elements[i - 1];
+            reserve(capacity * 2);
         }
-        // 插入新元素
-        elements[index] = value;
+        // 如果扩容,此时elements已经指向新的内存
+        // 末尾的元素移动构造到未初始化的位置size上，[index, size - 1)中的元素依次向后移动赋值一个位置
+        new (elements + size) T(std::move(elements[size - 1]));
         size++;
+        std::move_backward(elements + index, elements + size - 2, elements + size - 1);
+        // 插入新元素
+        elements[index] = std::move(copy);
     }
 
     // 删除数组末尾的元素
@@ -131,12 +223,14 @@ public:
         if (size > 0)
         {
             size--;
+            elements[size].~T(); // 析构元素，内存留给以后的元素
         }
     }
 
     // 清空数组
     void clear()
     {
+        destroy(elements, elements + size);
         size = 0;
     }
 
@@ -168,7 +262,7 @@ public:
     // 打印数组中的元素
     void printElements() const
     {
-        for (int i = 0; i < size; i++)
+        for (size_t i = 0; i < size; i++)
         {
             std::cout << elements[i] << " ";
         }
@@ -180,13 +274,104 @@ public:
     {
         if (newCapacity > capacity)
         {
-            T *newElements = new T[newCapacity];
-            std::copy(elements, elements + size, newElements);
-            delete[] elements;
+            T *newElements = allocate(newCapacity); // 只分配内存，不构造元素
+            try
+            {
+                relocate(elements, size, newElements);
+            }
+            catch (...)
+            {
+                deallocate(newElements, newCapacity);
+                throw;
+            }
+            deallocate(elements, capacity);
             elements = newElements;
             capacity = newCapacity;
         }
     }
+
+private:
+    // 分配能放下n个T的原始内存（不构造任何元素，new T[n]会默认构造n个元素）
+    static T *allocate(size_t n)
+    {
+        if (n == 0)
+        {
+            return nullptr;
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+    }
+
+    // 释放allocate分配的内存（元素必须已经析构）
+    static void deallocate(T *p, size_t n)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete(p, n * sizeof(T));
+        }
+    }
+
+    // 析构[first, last)中的元素（int这种平凡析构的类型什么都不用做）
+    static void destroy(T *first, T *last)
+    {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            for (; first != last; ++first)
+            {
+                first->~T();
+            }
+        }
+    }
+
+    // 把from中的n个元素搬到未初始化的内存to上，搬完后from中的元素都已析构（from的内存由调用者释放）
+    /*
+        平凡可拷贝的类型（int、double、只含这些成员的结构体）：一次memcpy，不需要逐个构造和析构。
+            C++17没有"可平凡重定位"的类型萃取，这里用is_trivially_copyable作为保守的近似。
+        移动构造不抛异常的类型（string等）：逐个移动构造，只搬运指针，不拷贝字符串内容。
+        移动构造可能抛异常的类型：move_if_noexcept退回到拷贝，中途抛异常时from原样保留（强异常安全保证）。
+    */
+    static void relocate(T *from, size_t n, T *to)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            std::memcpy(static_cast<void *>(to), static_cast<const void *>(from), n * sizeof(T));
+        }
+        else
+        {
+            size_t built = 0;
+            try
+            {
+                for (; built < n; built++)
+                {
+                    new (to + built) T(std::move_if_noexcept(from[built]));
+                }
+            }
+            catch (...)
+            {
+                destroy(to, to + built);
+                throw;
+            }
+            destroy(from, from + n);
+        }
+    }
 };
 
 // main主函数
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstdint>
+#include "KLruCache.h"
+#include "MyDeque.h" // 手写STL中循环数组实现的MySTL::Deque，用作A1in和A1out两个FIFO队列（所在目录由test/CMakeLists.txt加入头文件搜索路径）
+
+namespace PerCache
+{
+    // K2QCache类：2Q缓存策略（Johnson & Shasha的完整版2Q）
+    /*
+        缓存分成三部分：
+            A1in ：FIFO队列，保存最近第一次进入缓存的key和value（常驻），容量参考值 _kin = 总容量 * kinRatio
+            A1out：FIFO队列，只保存从A1in淘汰出去的key（"幽灵"，不占value的内存），容量 _kout = 总容量 * koutRatio
+            Am   ：LRU链表（和KSlruCache的段一样是LruNode双向链表），保存被证明会被再次访问的key和value
+        put一个新key：进入A1in；put一个还在A1out中的key：说明它在短时间内被再次使用，直接进入Am。
+        A1in中的key命中时什么都不做（和原论文一样，短时间内的连续访问不算"再次使用"），Am中的key命中时移到最新位置。
+        需要腾出空间时：A1in的常驻个数超过_kin就淘汰A1in最老的key并记入A1out，否则淘汰Am中最久未使用的key。
+        一次性的扫描只会经过A1in和A1out，不会进入Am，所以Am中的热点数据不会被冲掉。
+
+        A1in和A1out用手写STL中的Deque（循环数组），而不是每个key一个链表节点：
+            push_back/pop_front都是数组下标的移动，命中A1in时不需要像KLruKCache的主缓存那样摘下、插入链表节点。
+            Deque不支持删除中间的元素，所以用"惰性删除"：队列中的每一项带着入队时的序号，哈希表中也记着这个序号。
+            remove(key)、A1out中的key进入Am时只删除哈希表中的记录，队列中的那一项留着，
+            出队时发现序号和哈希表对不上（或者key已经不在哈希表中）就直接丢弃。
+            队列中的失效项超过有效项时整理一次（compact），队列长度不会无限增长。
+    */
+    template <typename Key, typename Value>
+    class K2QCache : public KICachePolicy<Key, Value>
+    {
+    public:
+        using LruNodeType = LruNode<Key, Value>;
+        using NodePtr = shared_ptr<LruNodeType>;
+
+    private:
+        // A1in、A1out队列中的一项：key + 入队序号
+        struct FifoItem
+        {
+            Key key{};
+            uint64_t seq = 0;
+        };
+        // A1in中的常驻数据
+        struct InEntry
+        {
+            Value value;
+            uint64_t seq;
+        };
+
+        int _capacity;  // 总容量（A1in + Am的常驻key个数）
+        size_t _kin;    // A1in的常驻个数超过它时优先淘汰A1in
+        size_t _kout;   // A1out最多记录的key个数
+        uint64_t _nextSeq = 0;
+
+        unordered_map<Key, InEntry> _inMap;      // A1in：key -> value + 序号
+        MySTL::Deque<FifoItem> _inQueue;         // A1in的FIFO队列（队头最老）
+        unordered_map<Key, uint64_t> _ghostMap;  // A1out：key -> 序号
+        MySTL::Deque<FifoItem> _ghostQueue;      // A1out的FIFO队列（队头最老）
+        unordered_map<Key, NodePtr> _mainMap;    // Am：key -> 链表节点
+        NodePtr _dummyHead;                      // Am的哨兵头节点（之后是最久未使用的节点）
+        NodePtr _dummyTail;                      // Am的哨兵尾节点（之前是最新的节点）
+        mutex _mutex;
+
+    public:
+        // kinRatio：A1in占总容量的比例（论文建议25%），koutRatio：A1out能记住的key个数占总容量的比例（论文建议50%）
+        K2QCache(int capacity, double kinRatio = 0.25, double koutRatio = 0.5)
+            : _capacity(capacity)
+        {
+            kinRatio = min(max(kinRatio, 0.0), 1.0);
+            koutRatio = max(koutRatio, 0.0);
+            _kin = capacity > 0 ? static_cast<size_t>(capacity * kinRatio) : 0;
+            _kout = capacity > 0 ? max<size_t>(1, static_cast<size_t>(capacity * koutRatio)) : 0;
+            _dummyHead = make_shared<LruNodeType>(Key(), Value());
+            _dummyTail = make_shared<LruNodeType>(Key(), Value());
+            _dummyHead->_next = _dummyTail;
+            _dummyTail->_prev = _dummyHead;
+        }
+
+        // Deque没有拷贝构造，整个缓存也不允许拷贝
+        K2QCache(const K2QCache &) = delete;
+        K2QCache &operator=(const K2QCache &) = delete;
+
+        ~K2QCache() override
+        {
+            // 断开Am链表的shared_ptr链，避免很长的链表递归析构
+            NodePtr node = _dummyHead;
+            while (node)
+            {
+                NodePtr next = node->_next;
+                node->_next = nullptr;
+                node = next;
+            }
+        }
+
+        void put(Key key, Value value) override
+        {
+            if (_capacity <= 0)
+                return;
+            lock_guard<mutex> lock(_mutex);
+            auto mainIt = _mainMap.find(key);
+            if (mainIt != _mainMap.end())
+            {
+                mainIt->second->setValue(value);
+                moveToMostRecent(mainIt->second);
+                return;
+            }
+            auto inIt = _inMap.find(key);
+            if (inIt != _inMap.end())
+            {
+                inIt->second.value = value; // A1in中的key更新value，位置不变
+                return;
+            }
+            auto ghostIt = _ghostMap.find(key);
+            if (ghostIt != _ghostMap.end())
+            {
+                // 从A1淘汰以后又被用到：进入Am（A1out队列中的那一项留给惰性删除）
+                _ghostMap.erase(ghostIt);
+                compactIfNeeded(_ghostQueue, _ghostMap);
+                reclaim();
+                NodePtr node = make_shared<LruNodeType>(key, value);
+                pushBack(node);
+                _mainMap.emplace(key, node);
+                return;
+            }
+            // 第一次出现的key进入A1in
+            reclaim();
+            uint64_t seq = _nextSeq++;
+            _inQueue.push_back(FifoItem{key, seq});
+            _inMap.emplace(key, InEntry{value, seq});
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto mainIt = _mainMap.find(key);
+            if (mainIt != _mainMap.end())
+            {
+                moveToMostRecent(mainIt->second);
+                value = mainIt->second->getValue();
+                return true;
+            }
+            auto inIt = _inMap.find(key);
+            if (inIt != _inMap.end())
+            {
+                value = inIt->second.value; // A1in命中：不移动任何东西
+                return true;
+            }
+            return false; // A1out中只有key，没有value，也算未命中
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value; // 如果key不存在，则返回默认值
+        }
+
+        void remove(Key key)
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto mainIt = _mainMap.find(key);
+            if (mainIt != _mainMap.end())
+            {
+                unlink(mainIt->second);
+                _mainMap.erase(mainIt);
+                return;
+            }
+            // A1in、A1out只删除哈希表中的记录，队列中的项出队时丢弃
+            if (_inMap.erase(key) > 0)
+                compactIfNeeded(_inQueue, _inMap);
+            else if (_ghostMap.erase(key) > 0)
+                compactIfNeeded(_ghostQueue, _ghostMap);
+        }
+
+        // 常驻的key个数（A1in + Am）
+        size_t size()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _inMap.size() + _mainMap.size();
+        }
+
+        // 三部分各自的key个数（主要用于测试和观察）
+        size_t inSize()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _inMap.size();
+        }
+        size_t mainSize()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _mainMap.size();
+        }
+        size_t ghostSize()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _ghostMap.size();
+        }
+
+    private:
+        // 缓存满了时腾出一个位置
+        void reclaim()
+        {
+            if (_inMap.size() + _mainMap.size() < static_cast<size_t>(_capacity))
+                return;
+            if (_inMap.size() > _kin || _mainMap.empty())
+            {
+                // 淘汰A1in最老的key，key记入A1out
+                Key victim;
+                if (!popOldest(_inQueue, _inMap, victim))
+                    return;
+                _inMap.erase(victim);
+                uint64_t seq = _nextSeq++;
+                _ghostQueue.push_back(FifoItem{victim, seq});
+                _ghostMap[victim] = seq;
+                if (_ghostMap.size() > _kout)
+                {
+                    Key forgotten;
+                    if (popOldest(_ghostQueue, _ghostMap, forgotten))
+                        _ghostMap.erase(forgotten);
+                }
+            }
+            else
+            {
+                // 淘汰Am中最久未使用的key（不记入A1out）
+                NodePtr victim = _dummyHead->_next;
+                unlink(victim);
+                _mainMap.erase(victim->getKey());
+            }
+        }
+
+        // 序号和哈希表中记录的一致，说明队列中的这一项仍然有效
+        static bool isLive(const InEntry &entry, uint64_t seq) { return entry.seq == seq; }
+        static bool isLive(uint64_t recorded, uint64_t seq) { return recorded == seq; }
+
+        // 弹出队列中最老的有效项（途中遇到的失效项直接丢弃），队列中没有有效项时返回false
+        template <typename Map>
+        static bool popOldest(MySTL::Deque<FifoItem> &queue, Map &map, Key &key)
+        {
+            while (!queue.empty())
+            {
+                FifoItem item = queue.front();
+                queue.pop_front();
+                auto it = map.find(item.key);
+                if (it != map.end() && isLive(it->second, item.seq))
+                {
+                    key = item.key;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 失效项比有效项多时，按原来的顺序只保留有效项（每次整理至少丢弃一半，均摊O(1)）
+        template <typename Map>
+        static void compactIfNeeded(MySTL::Deque<FifoItem> &queue, Map &map)
+        {
+            if (queue.getSize() <= 2 * map.size() + 16)
+                return;
+            size_t count = queue.getSize();
+            for (size_t i = 0; i < count; i++)
+            {
+                FifoItem item = queue.front();
+                queue.pop_front();
+                auto it = map.find(item.key);
+                if (it != map.end() && isLive(it->second, item.seq))
+                    queue.push_back(item);
+            }
+        }
+
+        // Am链表操作（和KSlruCache的pushBack/unlink相同）
+        void moveToMostRecent(NodePtr node)
+        {
+            unlink(node);
+            pushBack(node);
+        }
+
+        void pushBack(NodePtr node)
+        {
+            auto prev = _dummyTail->_prev;
+            prev.lock()->_next = node;
+            node->_next = _dummyTail;
+            _dummyTail->_prev = node;
+            node->_prev = prev;
+        }
+
+        void unlink(NodePtr node)
+        {
+            if (!node->_prev.expired() && node->_next)
+            {
+                auto prev = node->_prev.lock();
+                prev->_next = node->_next;
+                node->_next->_prev = prev;
+                node->_next = nullptr;
+            }
+        }
+    };
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>    //sort
+#include <atomic>
+#include <cstdint>
+#include <functional>   //hash
+#include <memory>
+#include <mutex>
+#include <shared_mutex> //get用共享锁
+#include <vector>
+#include "KICachePolicy.h"
+using namespace std;
+
+namespace PerCache
+{
+    // KApproxLruCache类：采样的近似LRU（Redis的做法），用于上亿个元素的超大缓存
+    /*
+        KLruCache每个元素一个LruNode：两个链表指针（weak_ptr + shared_ptr，共32字节）、shared_ptr的控制块、
+        再加上unordered_map的节点，额外开销比int/int这样的小value本身大得多。
+        这里没有链表：
+            所有元素直接放在一个开放寻址（线性探测）的扁平数组_slots中
+            每个元素只记一个24位的粗粒度访问时钟（和"是否占用"标志一起放在一个uint32_t里）
+            淘汰时随机取samples个元素，淘汰其中访问时钟最老的
+            可选的淘汰池（poolSize > 0）：把每次采样中较老的候选留到下一次淘汰，相当于采样数变多，更接近真正的LRU
+        get只在共享锁下读数组，命中时用一次relaxed store更新访问时钟，不修改任何链表；
+        put/remove持有独占锁。
+        时钟：粗粒度的访问时钟（Redis的LRU_CLOCK也只有秒级/毫秒级精度）：
+            每2^_clockShift次put加1（在独占锁内），_clockShift按容量选择，使得put满一次容量时钟大约走4096格，
+            一个元素从插入到被淘汰大约经过容量次put，所以年龄的精度和缓存大小无关，上亿个元素时也不会很快回绕。
+            get读取当前时钟，"年龄" = 当前时钟 - 元素的时钟（按模2^24计算）。
+        年龄饱和：每次put顺带检查一个槽位（游标循环扫过整个数组），年龄超过2^23的元素把时钟改为"正好2^23格之前"。
+            扫完整个数组只需要 数组大小 次put，时钟只走了几千格，所以任何元素的年龄都到不了2^24，
+            长期未访问的元素不会因为回绕而看起来像刚访问过；代价是年龄超过2^23的元素之间不再区分先后。
+        容量在构造时固定，数组大小是不小于 容量*4/3 的2的幂（装载因子不超过0.75）。
+    */
+    template <typename Key, typename Value, typename Hasher = hash<Key>>
+    class KApproxLruCache : public KICachePolicy<Key, Value>
+    {
+    private:
+        static const uint32_t _occupied = 1u << 31;
+        static const uint32_t _clockMask = (1u << 24) - 1;
+        static const uint32_t _maxAge = 1u << 23;            // 年龄饱和的上限
+        static const size_t _ticksPerCapacity = 4096;        // put满一次容量时钟大约走的格数
+
+        struct Slot
+        {
+            Key key{};
+            Value value{};
+            uint32_t hash = 0;
+            atomic<uint32_t> meta{0}; // 最高位：是否占用；低24位：访问时钟
+        };
+
+        // 淘汰池中的一个候选
+        struct Candidate
+        {
+            size_t slot;
+            uint32_t hash;
+            uint32_t age;
+        };
+
+        size_t _capacity;
+        size_t _mask;
+        unique_ptr<Slot[]> _slots;
+        size_t _size = 0;
+        atomic<uint32_t> _clock{0}; // 当前时钟（低24位），get读取
+        uint64_t _puts = 0;         // put的次数（只在独占锁内修改）
+        int _clockShift = 0;        // 每2^_clockShift次put时钟加1
+        size_t _sweepCursor = 0;    // 年龄饱和检查的游标
+        int _samples;
+        size_t _poolSize;
+        vector<Candidate> _pool; // 淘汰池：上次淘汰时剩下的较老的候选
+        uint64_t _random = 0x9E3779B97F4A7C15ull;
+        Hasher _hasher;
+        shared_mutex _mutex;
+
+    public:
+        // samples：每次淘汰随机采样的元素个数；poolSize：淘汰池大小，0表示不使用淘汰池
+        explicit KApproxLruCache(size_t capacity, int samples = 5, size_t poolSize = 16)
+            : _capacity(capacity), _samples(samples > 0 ? samples : 1), _poolSize(poolSize)
+        {
+            size_t tableSize = 8;
+            while (tableSize * 3 < capacity * 4)
+                tableSize <<= 1;
+            _mask = tableSize - 1;
+            _slots.reset(new Slot[tableSize]);
+            while ((capacity >> _clockShift) > _ticksPerCapacity)
+                _clockShift++;
+            _pool.reserve(_poolSize + _samples);
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            uint32_t hash = hashOf(key);
+            shared_lock<shared_mutex> lock(_mutex);
+            size_t slot = findSlot(key, hash);
+            if (slot == SIZE_MAX)
+                return false;
+            value = _slots[slot].value;
+            // 只更新访问时钟：relaxed store，不需要和其它读者同步
+            _slots[slot].meta.store(_occupied | (_clock.load(memory_order_relaxed) & _clockMask), memory_order_relaxed);
+            return true;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        void put(Key key, Value value) override
+        {
+            if (_capacity == 0)
+                return;
+            uint32_t hash = hashOf(key);
+            unique_lock<shared_mutex> lock(_mutex);
+            uint32_t now = tick();
+            size_t slot = findSlot(key, hash);
+            if (slot != SIZE_MAX)
+            {
+                _slots[slot].value = value;
+                _slots[slot].meta.store(_occupied | now, memory_order_relaxed);
+                return;
+            }
+            if (_size >= _capacity)
+                evictOne(now);
+            size_t i = hash & _mask;
+            while (_slots[i].meta.load(memory_order_relaxed) & _occupied)
+                i = (i + 1) & _mask;
+            _slots[i].key = key;
+            _slots[i].value = value;
+            _slots[i].hash = hash;
+            _slots[i].meta.store(_occupied | now, memory_order_relaxed);
+            _size++;
+        }
+
+        bool remove(Key key)
+        {
+            uint32_t hash = hashOf(key);
+            unique_lock<shared_mutex> lock(_mutex);
+            size_t slot = findSlot(key, hash);
+            if (slot == SIZE_MAX)
+                return false;
+            eraseSlot(slot);
+            return true;
+        }
+
+        size_t size()
+        {
+            shared_lock<shared_mutex> lock(_mutex);
+            return _size;
+        }
+
+        size_t capacity() const { return _capacity; }
+
+        // 每个槽位占用的字节数（不含key/value本身在堆上的部分），用来估算内存
+        static constexpr size_t slotBytes() { return sizeof(Slot); }
+        size_t tableSize() const { return _mask + 1; }
+
+    private:
+        uint32_t hashOf(const Key &key) const
+        {
+            return static_cast<uint32_t>(_hasher(key));
+        }
+
+        size_t findSlot(const Key &key, uint32_t hash) const
+        {
+            for (size_t i = hash & _mask;; i = (i + 1) & _mask)
+            {
+                uint32_t meta = _slots[i].meta.load(memory_order_relaxed);
+                if (!(meta & _occupied))
+                    return SIZE_MAX;
+                if (_slots[i].hash == hash && _slots[i].key == key)
+                    return i;
+            }
+        }
+
+        uint64_t nextRandom()
+        {
+            // xorshift64：只在独占锁内调用
+            _random ^= _random << 13;
+            _random ^= _random >> 7;
+            _random ^= _random << 17;
+            return _random;
+        }
+
+        uint32_t ageOf(size_t slot, uint32_t now) const
+        {
+            return (now - _slots[slot].meta.load(memory_order_relaxed)) & _clockMask;
+        }
+
+        // put时推进时钟（只在独占锁内调用），并顺带做一个槽位的年龄饱和检查，返回当前时钟
+        uint32_t tick()
+        {
+            _puts++;
+            uint32_t now = static_cast<uint32_t>(_puts >> _clockShift) & _clockMask;
+            _clock.store(now, memory_order_relaxed);
+            size_t slot = _sweepCursor;
+            _sweepCursor = (_sweepCursor + 1) & _mask;
+            uint32_t meta = _slots[slot].meta.load(memory_order_relaxed);
+            if ((meta & _occupied) && ((now - meta) & _clockMask) > _maxAge)
+            {
+                // get可能同时在共享锁下更新这个元素的时钟：CAS失败说明刚被访问过，不需要再改
+                _slots[slot].meta.compare_exchange_strong(meta, _occupied | ((now - _maxAge) & _clockMask),
+                                                          memory_order_relaxed);
+            }
+            return now;
+        }
+
+        // 淘汰一个元素：随机采样samples个已占用的槽位，和淘汰池中的候选一起比较，淘汰最老的
+        void evictOne(uint32_t now)
+        {
+            // 淘汰池中的候选可能已经被访问过（年龄变了）、被删除或者被移动了，重新检查
+            size_t kept = 0;
+            for (auto &candidate : _pool)
+            {
+                uint32_t meta = _slots[candidate.slot].meta.load(memory_order_relaxed);
+                if ((meta & _occupied) && _slots[candidate.slot].hash == candidate.hash)
+                {
+                    candidate.age = ageOf(candidate.slot, now);
+                    _pool[kept++] = candidate;
+                }
+            }
+            _pool.resize(kept);
+            for (int sampled = 0; sampled < _samples;)
+            {
+                size_t slot = nextRandom() & _mask;
+                if (!(_slots[slot].meta.load(memory_order_relaxed) & _occupied))
+                    continue; // 装载因子不低于一半左右，很快就能采到
+                sampled++;
+                bool duplicate = false;
+                for (auto &candidate : _pool)
+                    duplicate = duplicate || candidate.slot == slot;
+                if (!duplicate)
+                    _pool.push_back(Candidate{slot, _slots[slot].hash, ageOf(slot, now)});
+            }
+            // 找出最老的
+            size_t oldest = 0;
+            for (size_t i = 1; i < _pool.size(); i++)
+            {
+                if (_pool[i].age > _pool[oldest].age)
+                    oldest = i;
+            }
+            size_t victim = _pool[oldest].slot;
+            _pool.erase(_pool.begin() + oldest);
+            if (_poolSize == 0)
+            {
+                _pool.clear();
+            }
+            else if (_pool.size() > _poolSize)
+            {
+                // 只保留最老的poolSize个候选
+                sort(_pool.begin(), _pool.end(), [](const Candidate &a, const Candidate &b)
+                     { return a.age > b.age; });
+                _pool.resize(_poolSize);
+            }
+            eraseSlot(victim);
+        }
+
+        // 删除槽位：向后移动删除（探测链上后面的元素往前补，不留墓碑）
+        void eraseSlot(size_t hole)
+        {
+            for (size_t i = (hole + 1) & _mask;; i = (i + 1) & _mask)
+            {
+                uint32_t meta = _slots[i].meta.load(memory_order_relaxed);
+                if (!(meta & _occupied))
+                    break;
+                size_t home = _slots[i].hash & _mask;
+                if (((i - home) & _mask) >= ((i - hole) & _mask))
+                {
+                    _slots[hole].key = move(_slots[i].key);
+                    _slots[hole].value = move(_slots[i].value);
+                    _slots[hole].hash = _slots[i].hash;
+                    _slots[hole].meta.store(meta, memory_order_relaxed);
+                    hole = i;
+                }
+            }
+            _slots[hole].key = Key();
+            _slots[hole].value = Value();
+            _slots[hole].meta.store(0, memory_order_relaxed);
+            _size--;
+        }
+    };
+}
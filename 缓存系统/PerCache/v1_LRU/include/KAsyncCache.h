@@ -0,0 +1,605 @@
+#pragma once
+
+// 这个头文件用到C++20协程，使用它的目标需要用C++20编译（见test/CMakeLists.txt中的testKAsyncCache）
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional> //hash、function
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "KLruCache.h"
+using namespace std;
+
+namespace PerCache
+{
+    // KExecutor类：内置的小型执行器（线程池 + 定时器），用来恢复挂起的协程
+    /*
+        只负责"在某个工作线程上resume一个协程"：
+            post(handle)             —— 尽快在工作线程上恢复
+            postAfter(delay, handle) —— delay之后在工作线程上恢复
+        协程里用co_await executor.schedule()切换到工作线程，用co_await executor.sleepFor(delay)挂起一段时间（不占用线程）。
+        析构时停止所有工作线程，还没来得及恢复的协程不会再被恢复。
+    */
+    class KExecutor
+    {
+    private:
+        struct Timed
+        {
+            chrono::steady_clock::time_point when;
+            uint64_t seq; // 同一时刻按提交顺序
+            coroutine_handle<> handle;
+            bool operator>(const Timed &other) const
+            {
+                return when != other.when ? when > other.when : seq > other.seq;
+            }
+        };
+
+        mutex _mutex;
+        condition_variable _cv;
+        deque<coroutine_handle<>> _ready;
+        priority_queue<Timed, vector<Timed>, greater<Timed>> _timers;
+        uint64_t _seq = 0;
+        bool _stop = false;
+        vector<thread> _workers;
+
+    public:
+        explicit KExecutor(int threadNum = 1)
+        {
+            if (threadNum <= 0)
+                threadNum = 1;
+            for (int i = 0; i < threadNum; i++)
+                _workers.emplace_back([this]()
+                                      { run(); });
+        }
+
+        ~KExecutor()
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+            for (auto &worker : _workers)
+                worker.join();
+        }
+
+        KExecutor(const KExecutor &) = delete;
+        KExecutor &operator=(const KExecutor &) = delete;
+
+        void post(coroutine_handle<> handle)
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _ready.push_back(handle);
+            }
+            _cv.notify_one();
+        }
+
+        void postAfter(chrono::milliseconds delay, coroutine_handle<> handle)
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _timers.push(Timed{chrono::steady_clock::now() + delay, _seq++, handle});
+            }
+            _cv.notify_one();
+        }
+
+        // co_await executor.schedule()：挂起当前协程，在工作线程上恢复
+        auto schedule()
+        {
+            struct Awaiter
+            {
+                KExecutor *executor;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(coroutine_handle<> handle) { executor->post(handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{this};
+        }
+
+        // co_await executor.sleepFor(delay)：挂起当前协程delay时间，期间不占用任何线程
+        auto sleepFor(chrono::milliseconds delay)
+        {
+            struct Awaiter
+            {
+                KExecutor *executor;
+                chrono::milliseconds delay;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(coroutine_handle<> handle) { executor->postAfter(delay, handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{this, delay};
+        }
+
+    private:
+        void run()
+        {
+            unique_lock<mutex> lock(_mutex);
+            while (!_stop)
+            {
+                // 到期的定时任务移到就绪队列
+                auto now = chrono::steady_clock::now();
+                while (!_timers.empty() && _timers.top().when <= now)
+                {
+                    _ready.push_back(_timers.top().handle);
+                    _timers.pop();
+                }
+                if (!_ready.empty())
+                {
+                    coroutine_handle<> handle = _ready.front();
+                    _ready.pop_front();
+                    lock.unlock();
+                    handle.resume();
+                    lock.lock();
+                }
+                else if (!_timers.empty())
+                {
+                    auto deadline = _timers.top().when; // 拷贝出来：等待期间别的线程插入定时任务可能让堆重新分配
+                    _cv.wait_until(lock, deadline);
+                }
+                else
+                {
+                    _cv.wait(lock);
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    class KTask;
+
+    // KTask的promise中和返回值类型无关的部分：完成时把控制权交给co_await它的协程（对称转移，不会越调越深）
+    class KTaskPromiseBase
+    {
+    public:
+        coroutine_handle<> _continuation;
+        exception_ptr _error;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            template <typename Promise>
+            coroutine_handle<> await_suspend(coroutine_handle<Promise> handle) noexcept
+            {
+                coroutine_handle<> next = handle.promise()._continuation;
+                return next ? next : noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        suspend_always initial_suspend() noexcept { return {}; } // 惰性启动：被co_await时才开始执行
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void unhandled_exception() { _error = current_exception(); }
+    };
+
+    template <typename T>
+    class KTaskPromise : public KTaskPromiseBase
+    {
+    public:
+        optional<T> _result;
+        KTask<T> get_return_object();
+        void return_value(T value) { _result.emplace(move(value)); }
+        T takeResult()
+        {
+            if (_error)
+                rethrow_exception(_error);
+            return move(*_result);
+        }
+    };
+
+    template <>
+    class KTaskPromise<void> : public KTaskPromiseBase
+    {
+    public:
+        KTask<void> get_return_object();
+        void return_void() {}
+        void takeResult()
+        {
+            if (_error)
+                rethrow_exception(_error);
+        }
+    };
+
+    // KTask类：协程的返回类型，co_await它得到协程的返回值（协程中抛出的异常在co_await处重新抛出）
+    template <typename T>
+    class KTask
+    {
+    public:
+        using promise_type = KTaskPromise<T>;
+
+    private:
+        coroutine_handle<promise_type> _handle;
+
+    public:
+        explicit KTask(coroutine_handle<promise_type> handle) : _handle(handle) {}
+        KTask(KTask &&other) noexcept : _handle(exchange(other._handle, nullptr)) {}
+        KTask &operator=(KTask &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (_handle)
+                    _handle.destroy();
+                _handle = exchange(other._handle, nullptr);
+            }
+            return *this;
+        }
+        KTask(const KTask &) = delete;
+        KTask &operator=(const KTask &) = delete;
+
+        ~KTask()
+        {
+            if (_handle)
+                _handle.destroy();
+        }
+
+        auto operator co_await() noexcept
+        {
+            struct Awaiter
+            {
+                coroutine_handle<promise_type> handle;
+                bool await_ready() const noexcept { return false; }
+                coroutine_handle<> await_suspend(coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise()._continuation = awaiting;
+                    return handle; // 开始执行被等待的协程
+                }
+                T await_resume() { return handle.promise().takeResult(); }
+            };
+            return Awaiter{_handle};
+        }
+    };
+
+    template <typename T>
+    KTask<T> KTaskPromise<T>::get_return_object()
+    {
+        return KTask<T>(coroutine_handle<KTaskPromise<T>>::from_promise(*this));
+    }
+
+    inline KTask<void> KTaskPromise<void>::get_return_object()
+    {
+        return KTask<void>(coroutine_handle<KTaskPromise<void>>::from_promise(*this));
+    }
+
+    // KDetached：立即开始执行、没有人等待的协程（spawn/syncWait的外壳），结束时自己销毁
+    struct KDetached
+    {
+        struct promise_type
+        {
+            KDetached get_return_object() { return {}; }
+            suspend_never initial_suspend() noexcept { return {}; }
+            suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { terminate(); }
+        };
+    };
+
+    // 在后台运行一个任务，不等待它结束（任务中未捕获的异常会终止程序）
+    inline KDetached spawn(KTask<void> task)
+    {
+        co_await task;
+    }
+
+    // syncWait：在普通线程中阻塞等待一个任务结束（测试、main函数中用，协程里不要用）
+    template <typename T>
+    struct KSyncWaitState
+    {
+        mutex stateMutex;
+        condition_variable cv;
+        bool done = false;
+        optional<T> result;
+        exception_ptr error;
+    };
+
+    template <typename T>
+    KDetached runSyncWait(KTask<T> task, KSyncWaitState<T> *state)
+    {
+        try
+        {
+            state->result.emplace(co_await task);
+        }
+        catch (...)
+        {
+            state->error = current_exception();
+        }
+        lock_guard<mutex> lock(state->stateMutex);
+        state->done = true;
+        state->cv.notify_one(); // 持锁通知：等待的线程返回后state就被销毁了
+    }
+
+    inline KDetached runSyncWait(KTask<void> task, KSyncWaitState<bool> *state)
+    {
+        try
+        {
+            co_await task;
+            state->result.emplace(true);
+        }
+        catch (...)
+        {
+            state->error = current_exception();
+        }
+        lock_guard<mutex> lock(state->stateMutex);
+        state->done = true;
+        state->cv.notify_one();
+    }
+
+    template <typename T>
+    T syncWait(KTask<T> task)
+    {
+        using State = KSyncWaitState<conditional_t<is_void_v<T>, bool, T>>;
+        State state;
+        runSyncWait(move(task), &state);
+        unique_lock<mutex> lock(state.stateMutex);
+        state.cv.wait(lock, [&state]()
+                      { return state.done; });
+        if (state.error)
+            rethrow_exception(state.error);
+        if constexpr (!is_void_v<T>)
+            return move(*state.result);
+    }
+
+    class KAsyncMutex;
+
+    // co_await mutex.lock()的结果：析构时解锁
+    class KAsyncLockGuard
+    {
+    private:
+        KAsyncMutex *_mutex;
+
+    public:
+        explicit KAsyncLockGuard(KAsyncMutex *mutex) : _mutex(mutex) {}
+        KAsyncLockGuard(KAsyncLockGuard &&other) noexcept : _mutex(exchange(other._mutex, nullptr)) {}
+        KAsyncLockGuard(const KAsyncLockGuard &) = delete;
+        KAsyncLockGuard &operator=(const KAsyncLockGuard &) = delete;
+        ~KAsyncLockGuard() { unlock(); }
+        inline void unlock();
+    };
+
+    // KAsyncMutex类：协程用的互斥锁
+    /*
+        co_await mutex.lock()：锁空闲时直接拿到；被占用时把协程挂到等待队列上并挂起，不阻塞当前线程。
+        解锁时如果有人在等，锁直接交给队首的协程（_locked保持为true），并把它交给执行器恢复，
+        所以等待者按先来后到拿到锁，也不会在解锁的线程里递归恢复一长串协程。
+        内部的std::mutex只保护_locked和等待队列，持有时间是几条指令，不会跨越挂起点。
+    */
+    class KAsyncMutex
+    {
+    private:
+        KExecutor *_executor;
+        mutex _mutex;
+        bool _locked = false;
+        deque<coroutine_handle<>> _waiters;
+
+    public:
+        explicit KAsyncMutex(KExecutor &executor) : _executor(&executor) {}
+
+        auto lock()
+        {
+            struct Awaiter
+            {
+                KAsyncMutex *mutex;
+                bool await_ready() { return mutex->tryLock(); }
+                bool await_suspend(coroutine_handle<> handle)
+                {
+                    lock_guard<std::mutex> guard(mutex->_mutex);
+                    if (!mutex->_locked)
+                    {
+                        mutex->_locked = true;
+                        return false; // 刚刚被释放了，不用挂起
+                    }
+                    mutex->_waiters.push_back(handle);
+                    return true;
+                }
+                KAsyncLockGuard await_resume() { return KAsyncLockGuard(mutex); }
+            };
+            return Awaiter{this};
+        }
+
+        bool tryLock()
+        {
+            lock_guard<mutex> guard(_mutex);
+            if (_locked)
+                return false;
+            _locked = true;
+            return true;
+        }
+
+        void unlock()
+        {
+            coroutine_handle<> next;
+            {
+                lock_guard<mutex> guard(_mutex);
+                if (_waiters.empty())
+                {
+                    _locked = false;
+                    return;
+                }
+                next = _waiters.front(); // 锁直接交给它
+                _waiters.pop_front();
+            }
+            _executor->post(next);
+        }
+    };
+
+    inline void KAsyncLockGuard::unlock()
+    {
+        if (_mutex != nullptr)
+            exchange(_mutex, nullptr)->unlock();
+    }
+
+    // KAsyncLoadingCache类：协程版本的分片LRU加载缓存
+    /*
+        co_get(key)                 —— 只查缓存，返回optional<Value>
+        co_put(key, value)          —— 写入缓存
+        co_getOrLoad(key, loader)   —— 查缓存，未命中时co_await loader(key)加载（loader返回KTask<Value>），加载结果放进缓存
+        和KHashLruCaches一样按key的哈希值分片，但每个分片的锁是KAsyncMutex：锁被占用时协程挂起，而不是阻塞调度线程。
+        分片内部用KLruCache存储（它自己的std::mutex在分片锁之内，永远不会有竞争）。
+        未命中时不持有分片锁等待加载：
+            第一个未命中的协程在分片的_loading表中登记这个key，然后解锁、执行loader
+            加载期间同一个key的其它请求挂到登记的Pending上，挂起等待，不会重复加载（single flight）
+            加载完成后写入缓存、删除登记，再把所有等待者一起交给执行器恢复；loader抛出异常时每个等待者都会收到这个异常，
+            并且不会缓存任何东西，下一次请求重新加载
+    */
+    template <typename Key, typename Value, typename Hasher = hash<Key>>
+    class KAsyncLoadingCache
+    {
+    public:
+        using Loader = function<KTask<Value>(const Key &)>;
+
+    private:
+        // 一次进行中的加载
+        struct Pending
+        {
+            mutex pendingMutex;
+            bool done = false;
+            optional<Value> value;
+            exception_ptr error;
+            vector<coroutine_handle<>> waiters;
+        };
+
+        struct Shard
+        {
+            KAsyncMutex lock;
+            KLruCache<Key, Value, Hasher> cache;
+            unordered_map<Key, shared_ptr<Pending>, Hasher> loading;
+            Shard(KExecutor &executor, int capacity) : lock(executor), cache(capacity) {}
+        };
+
+        KExecutor &_executor;
+        vector<unique_ptr<Shard>> _shards;
+        Hasher _hasher;
+        atomic<uint64_t> _loads{0}; // 调用loader的次数
+
+    public:
+        KAsyncLoadingCache(size_t capacity, int shardNum, KExecutor &executor)
+            : _executor(executor)
+        {
+            if (shardNum <= 0)
+                shardNum = 1;
+            int shardCapacity = static_cast<int>((capacity + shardNum - 1) / shardNum);
+            for (int i = 0; i < shardNum; i++)
+                _shards.emplace_back(new Shard(executor, shardCapacity));
+        }
+
+        // 注意：协程的参数按值传递，调用者的临时对象在协程挂起后可能已经析构
+        KTask<optional<Value>> co_get(Key key)
+        {
+            Shard &shard = shardOf(key);
+            auto guard = co_await shard.lock.lock();
+            Value value{};
+            if (shard.cache.get(key, value))
+                co_return value;
+            co_return nullopt;
+        }
+
+        KTask<void> co_put(Key key, Value value)
+        {
+            Shard &shard = shardOf(key);
+            auto guard = co_await shard.lock.lock();
+            shard.cache.put(key, value);
+        }
+
+        KTask<Value> co_getOrLoad(Key key, Loader loader)
+        {
+            Shard &shard = shardOf(key);
+            shared_ptr<Pending> pending;
+            {
+                auto guard = co_await shard.lock.lock();
+                Value value{};
+                if (shard.cache.get(key, value))
+                    co_return value;
+                auto it = shard.loading.find(key);
+                if (it != shard.loading.end())
+                {
+                    pending = it->second;
+                    guard.unlock();
+                    co_return co_await waitFor(pending); // 别人正在加载，等它的结果
+                }
+                pending = make_shared<Pending>();
+                shard.loading.emplace(key, pending);
+            }
+
+            // 不持有分片锁执行加载
+            _loads++;
+            optional<Value> loaded;
+            exception_ptr error;
+            try
+            {
+                loaded.emplace(co_await loader(key));
+            }
+            catch (...)
+            {
+                error = current_exception();
+            }
+
+            {
+                auto guard = co_await shard.lock.lock();
+                if (!error)
+                    shard.cache.put(key, *loaded);
+                shard.loading.erase(key);
+            }
+            complete(pending, loaded, error);
+            if (error)
+                rethrow_exception(error);
+            co_return move(*loaded);
+        }
+
+        // 调用loader的次数（观察single flight是否生效）
+        uint64_t loadCount() const { return _loads.load(); }
+
+    private:
+        Shard &shardOf(const Key &key)
+        {
+            return *_shards[_hasher(key) % _shards.size()];
+        }
+
+        // 等待一次进行中的加载：加载已经完成就不挂起
+        auto waitFor(shared_ptr<Pending> pending)
+        {
+            struct Awaiter
+            {
+                shared_ptr<Pending> pending;
+                bool await_ready() const noexcept { return false; }
+                bool await_suspend(coroutine_handle<> handle)
+                {
+                    lock_guard<mutex> lock(pending->pendingMutex);
+                    if (pending->done)
+                        return false;
+                    pending->waiters.push_back(handle);
+                    return true;
+                }
+                Value await_resume()
+                {
+                    if (pending->error)
+                        rethrow_exception(pending->error);
+                    return *pending->value;
+                }
+            };
+            return Awaiter{move(pending)};
+        }
+
+        // 记录加载结果，并把所有等待者交给执行器一起恢复
+        void complete(const shared_ptr<Pending> &pending, const optional<Value> &value, exception_ptr error)
+        {
+            vector<coroutine_handle<>> waiters;
+            {
+                lock_guard<mutex> lock(pending->pendingMutex);
+                pending->value = value;
+                pending->error = error;
+                pending->done = true;
+                waiters.swap(pending->waiters);
+            }
+            for (auto handle : waiters)
+                _executor.post(handle);
+        }
+    };
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional> //hash
+#include <vector>
+using namespace std;
+
+namespace PerCache
+{
+    // KBloomFilter类：分块布隆过滤器（blocked Bloom filter），定期轮换
+    /*
+        普通布隆过滤器一个key的k个比特位分散在整个位数组中，一次查询要访问k个不同的缓存行。
+        分块布隆过滤器先用哈希值选出一个512比特（64字节，正好一个缓存行）的块，k个比特位都落在这个块里，
+        一次查询只访问一个缓存行，代价是误判率比普通布隆过滤器略高一点。
+
+        布隆过滤器不能删除元素，插入越多误判率越高。所以这里保存两代位数组：
+            插入只写当前代，查询两代都查；
+            当前代插入满rotateInterval个key后轮换：当前代变成上一代，原来的上一代清空后作为新的当前代。
+        任何一代最多只有rotateInterval个key，误判率不会超过构造时给定的目标；
+        一个key在最后一次插入之后，最多再经过两次轮换就会被"忘掉"。
+
+        和KLruKCache一样，KBloomFilter本身不加锁。
+    */
+    template <typename Key>
+    class KBloomFilter
+    {
+    private:
+        static const size_t BlockBits = 512;
+        static const size_t WordsPerBlock = BlockBits / 64;
+
+        size_t _blockNum;           // 每一代的块数
+        int _probes;                // 每个key在块内设置的比特位个数（k）
+        size_t _rotateInterval;     // 每一代最多插入的key个数
+        size_t _inserted = 0;       // 当前代已经插入的key个数
+        vector<uint64_t> _current;  // 当前代
+        vector<uint64_t> _previous; // 上一代
+
+    public:
+        // expectedKeys：每一代预计插入的key个数（也是轮换间隔）；falsePositiveRate：目标误判率
+        KBloomFilter(size_t expectedKeys, double falsePositiveRate = 0.01)
+            : _rotateInterval(expectedKeys > 0 ? expectedKeys : 1)
+        {
+            if (falsePositiveRate <= 0 || falsePositiveRate >= 1)
+                falsePositiveRate = 0.01;
+            // 最优比特数 m = -n*ln(p)/(ln2)^2，最优哈希个数 k = m/n*ln2
+            double ln2 = log(2.0);
+            double bits = -static_cast<double>(_rotateInterval) * log(falsePositiveRate) / (ln2 * ln2);
+            _blockNum = static_cast<size_t>(ceil(bits / BlockBits));
+            if (_blockNum == 0)
+                _blockNum = 1;
+            _probes = static_cast<int>(round(bits / _rotateInterval * ln2));
+            _probes = _probes < 1 ? 1 : (_probes > 16 ? 16 : _probes);
+            _current.assign(_blockNum * WordsPerBlock, 0);
+            _previous.assign(_blockNum * WordsPerBlock, 0);
+        }
+
+        // key可能存在（两代中任意一代命中）返回true；一定不存在返回false
+        bool contains(const Key &key) const
+        {
+            uint64_t h = hashOf(key);
+            return test(_current, h) || test(_previous, h);
+        }
+
+        void add(const Key &key)
+        {
+            uint64_t h = hashOf(key);
+            if (!test(_current, h))
+                insert(h);
+        }
+
+        // 查询并记录：之前见过返回true；第一次见到返回false，同时记录下来
+        bool containsOrAdd(const Key &key)
+        {
+            uint64_t h = hashOf(key);
+            if (test(_current, h))
+                return true;
+            bool seen = test(_previous, h);
+            insert(h); // 上一代中见过的也写入当前代，避免轮换后被忘掉
+            return seen;
+        }
+
+        // 立即轮换（例如后端存储批量写入后，让旧的"不存在"记录尽快失效）
+        void rotate()
+        {
+            _previous.swap(_current);
+            fill(_current.begin(), _current.end(), 0);
+            _inserted = 0;
+        }
+
+        void clear()
+        {
+            fill(_current.begin(), _current.end(), 0);
+            fill(_previous.begin(), _previous.end(), 0);
+            _inserted = 0;
+        }
+
+    private:
+        // std::hash<int>等是恒等函数，再混合一次，保证高低位都足够随机（splitmix64的终结函数）
+        static uint64_t hashOf(const Key &key)
+        {
+            uint64_t h = hash<Key>()(key);
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9ULL;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111ebULL;
+            h ^= h >> 31;
+            return h;
+        }
+
+        // 块下标用哈希值的高32位，块内的比特位用低32位做双重哈希：bit_i = h1 + i*h2
+        size_t blockOf(uint64_t h) const
+        {
+            return static_cast<size_t>(((h >> 32) * _blockNum) >> 32) * WordsPerBlock;
+        }
+
+        bool test(const vector<uint64_t> &bits, uint64_t h) const
+        {
+            const uint64_t *block = bits.data() + blockOf(h);
+            uint32_t h1 = static_cast<uint32_t>(h);
+            uint32_t h2 = (h1 >> 16) | 1;
+            for (int i = 0; i < _probes; i++)
+            {
+                uint32_t bit = (h1 + i * h2) % BlockBits;
+                if ((block[bit / 64] & (1ULL << (bit % 64))) == 0)
+                    return false;
+            }
+            return true;
+        }
+
+        void insert(uint64_t h)
+        {
+            if (_inserted >= _rotateInterval)
+                rotate();
+            uint64_t *block = _current.data() + blockOf(h);
+            uint32_t h1 = static_cast<uint32_t>(h);
+            uint32_t h2 = (h1 >> 16) | 1;
+            for (int i = 0; i < _probes; i++)
+            {
+                uint32_t bit = (h1 + i * h2) % BlockBits;
+                block[bit / 64] |= 1ULL << (bit % 64);
+            }
+            _inserted++;
+        }
+    };
+}
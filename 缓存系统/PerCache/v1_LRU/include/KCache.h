@@ -0,0 +1,555 @@
+#pragma once
+
+#include <atomic>        //KSpinLock的atomic_flag
+#include <cstdint>       //uint32_t
+#include <mutex>         //KMutexLock
+#include <thread>        //KSpinLock自旋失败时yield
+#include <unordered_map> //KNodeIndex、KLfuEviction
+#include <vector>
+#include <functional> //hash函数
+#include "KICachePolicy.h"
+using namespace std;
+
+/*
+    KCache：基于策略（policy-based）的静态分派缓存模板
+    KCache<Key, Value, Eviction, Index, Locking>
+        Eviction —— 淘汰策略：KLruEviction / KLruKEviction / KLfuEviction
+        Index    —— 索引结构：KNodeIndex（unordered_map，基于节点） / KFlatIndex（开放寻址的扁平数组）
+        Locking  —— 加锁策略：KMutexLock / KSpinLock / KNoLock
+    所有策略都是模板参数，调用在编译期就确定了，编译器可以把它们全部内联：
+        KNoLock的lock/unlock是空函数，单线程场景下没有任何同步开销；KCache本身不继承KICachePolicy，也没有虚函数调用。
+    需要通过KICachePolicy指针使用的老代码，可以用KCacheAdapter包装一层（只有这一层是虚调用）。
+
+    节点不再一个个make_shared，而是放在一个vector<Slot>里，用uint32_t的下标（slot id）代替指针，
+    淘汰策略和索引都只和slot id打交道。
+*/
+namespace PerCache
+{
+    // 前向声明 —— KLruKEviction内部用一个KCache保存历史访问次数
+    template <typename Key, typename Value,
+              template <typename> class Eviction,
+              template <typename> class Index,
+              typename Locking>
+    class KCache;
+
+    const uint32_t KNil = UINT32_MAX; // 空下标（相当于nullptr）
+
+    // （1）加锁策略
+    // 不加锁：单线程使用，lock/unlock都是空函数，内联后什么都不剩
+    struct KNoLock
+    {
+        void lock() {}
+        void unlock() {}
+    };
+
+    // 互斥锁：和KLruCache一样使用std::mutex
+    class KMutexLock
+    {
+    private:
+        mutex _mutex;
+
+    public:
+        void lock() { _mutex.lock(); }
+        void unlock() { _mutex.unlock(); }
+    };
+
+    // 自旋锁：临界区很短（只是改几个下标）时，避免mutex陷入内核
+    class KSpinLock
+    {
+    private:
+        atomic_flag _flag = ATOMIC_FLAG_INIT;
+
+    public:
+        void lock()
+        {
+            int spins = 0;
+            while (_flag.test_and_set(memory_order_acquire))
+            {
+                // 自旋一段时间还拿不到锁，就让出CPU，避免持锁线程被抢占时空转
+                if (++spins >= 64)
+                {
+                    std::this_thread::yield();
+                    spins = 0;
+                }
+            }
+        }
+        void unlock() { _flag.clear(memory_order_release); }
+    };
+
+    // （2）索引策略
+    /*
+        索引负责 key -> slot id 的映射。
+        find/insert/erase都额外接收slots（KCache中的节点数组），KFlatIndex需要通过slots[id].key比较key，
+        自己不再保存一份key；KNodeIndex用不到slots，直接忽略。
+    */
+    // 基于节点的索引：就是unordered_map（每个元素一个堆上的节点）
+    template <typename Key>
+    class KNodeIndex
+    {
+    private:
+        unordered_map<Key, uint32_t> _map;
+
+    public:
+        explicit KNodeIndex(size_t capacity)
+        {
+            _map.reserve(capacity); // 容量已知，提前分配好桶，避免插入时rehash
+        }
+
+        template <typename Slots>
+        uint32_t find(const Key &key, const Slots &) const
+        {
+            auto it = _map.find(key);
+            return it == _map.end() ? KNil : it->second;
+        }
+
+        template <typename Slots>
+        void insert(const Key &key, uint32_t id, const Slots &)
+        {
+            _map[key] = id;
+        }
+
+        template <typename Slots>
+        void erase(const Key &key, const Slots &)
+        {
+            _map.erase(key);
+        }
+    };
+
+    // 扁平索引：开放寻址 + 线性探测，所有桶在一块连续内存里
+    template <typename Key>
+    class KFlatIndex
+    {
+    private:
+        struct Bucket
+        {
+            uint32_t hash = 0; // key哈希值的低32位（探测时先比较它，相同才去比较key；删除时用它算初始位置）
+            uint32_t id = KNil; // slot id，KNil表示空桶
+        };
+        vector<Bucket> _buckets;
+        size_t _mask; // 桶数是2的幂，下标 = hash & _mask
+
+    public:
+        explicit KFlatIndex(size_t capacity)
+        {
+            // 元素个数不会超过capacity，桶数取 >= 2*capacity 的2的幂，负载因子始终 <= 0.5，永远不需要扩容
+            size_t bucketNum = 2;
+            while (bucketNum < capacity * 2)
+                bucketNum <<= 1;
+            _buckets.resize(bucketNum);
+            _mask = bucketNum - 1;
+        }
+
+        template <typename Slots>
+        uint32_t find(const Key &key, const Slots &slots) const
+        {
+            uint32_t h = hashOf(key);
+            for (size_t i = h & _mask;; i = (i + 1) & _mask)
+            {
+                const Bucket &b = _buckets[i];
+                if (b.id == KNil)
+                    return KNil; // 遇到空桶，说明key不存在
+                if (b.hash == h && slots[b.id].key == key)
+                    return b.id;
+            }
+        }
+
+        template <typename Slots>
+        void insert(const Key &key, uint32_t id, const Slots &)
+        {
+            uint32_t h = hashOf(key);
+            size_t i = h & _mask;
+            while (_buckets[i].id != KNil)
+                i = (i + 1) & _mask;
+            _buckets[i].hash = h;
+            _buckets[i].id = id;
+        }
+
+        template <typename Slots>
+        void erase(const Key &key, const Slots &slots)
+        {
+            uint32_t h = hashOf(key);
+            size_t i = h & _mask;
+            while (true)
+            {
+                if (_buckets[i].id == KNil)
+                    return;
+                if (_buckets[i].hash == h && slots[_buckets[i].id].key == key)
+                    break;
+                i = (i + 1) & _mask;
+            }
+            /*
+                后移删除（backward shift deletion）：不使用墓碑标记。
+                把后面"本该在更前面"的元素依次挪到空出来的位置，保证探测链不断。
+                判断能否挪动只需要桶里保存的hash，不用重新计算key的哈希值。
+            */
+            size_t j = i;
+            while (true)
+            {
+                j = (j + 1) & _mask;
+                if (_buckets[j].id == KNil)
+                    break;
+                size_t home = _buckets[j].hash & _mask; // 元素j理想的位置
+                // home落在(i, j]之间（考虑回绕）时不能挪，否则会挪到自己理想位置的前面
+                bool between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                if (!between)
+                {
+                    _buckets[i] = _buckets[j];
+                    i = j;
+                }
+            }
+            _buckets[i] = Bucket();
+        }
+
+    private:
+        static uint32_t hashOf(const Key &key)
+        {
+            return static_cast<uint32_t>(hash<Key>()(key));
+        }
+    };
+
+    // （3）淘汰策略
+    /*
+        淘汰策略只管理slot id的先后顺序，接口：
+            admit(key)   —— 新key是否允许进入缓存（LRU/LFU总是允许，LRU-K要访问满k次）
+            onMiss(key)  —— get没有命中
+            onInsert(id) / onAccess(id) / onErase(id)
+            victim()     —— 缓存满时应该淘汰的slot id
+        slot id小于capacity，所以链表指针可以直接用按id下标访问的数组。
+    */
+    // LRU：和KLruCache一样，头部最久未使用，尾部最新
+    template <typename Key>
+    class KLruEviction
+    {
+    private:
+        vector<uint32_t> _prev;
+        vector<uint32_t> _next;
+        uint32_t _head = KNil; // 最久未访问
+        uint32_t _tail = KNil; // 最近访问
+
+    public:
+        explicit KLruEviction(size_t capacity)
+            : _prev(capacity, KNil), _next(capacity, KNil)
+        {
+        }
+
+        bool admit(const Key &) { return true; }
+        void onMiss(const Key &) {}
+        void onInsert(uint32_t id) { pushBack(id); }
+        void onAccess(uint32_t id)
+        {
+            if (id == _tail)
+                return; // 已经是最新位置
+            unlink(id);
+            pushBack(id);
+        }
+        void onErase(uint32_t id) { unlink(id); }
+        uint32_t victim() const { return _head; }
+
+    private:
+        void pushBack(uint32_t id)
+        {
+            _prev[id] = _tail;
+            _next[id] = KNil;
+            if (_tail != KNil)
+                _next[_tail] = id;
+            else
+                _head = id;
+            _tail = id;
+        }
+
+        void unlink(uint32_t id)
+        {
+            if (_prev[id] != KNil)
+                _next[_prev[id]] = _next[id];
+            else
+                _head = _next[id];
+            if (_next[id] != KNil)
+                _prev[_next[id]] = _prev[id];
+            else
+                _tail = _prev[id];
+            _prev[id] = _next[id] = KNil;
+        }
+    };
+
+    // LRU-K：在LRU的基础上增加准入条件，一个key要被访问满k次才能进入缓存
+    /*
+        和KLruKCache的区别：
+            历史访问次数保存在一个KCache<Key, size_t, KLruEviction, KNodeIndex, KNoLock>里，
+            调用全部是静态分派，可以内联；历史里只记次数，不保存value（put满k次时直接带着value进入缓存）。
+        KLruKEviction本身不加锁，由外层KCache的Locking统一保护。
+    */
+    template <typename Key>
+    class KLruKEviction : public KLruEviction<Key>
+    {
+    private:
+        size_t _k;
+        KCache<Key, size_t, KLruEviction, KNodeIndex, KNoLock> _historyCounter; // 历史访问次数（有容量限制，按LRU淘汰）
+
+    public:
+        KLruKEviction(size_t capacity, int historyCapacity, size_t k)
+            : KLruEviction<Key>(capacity), _k(k), _historyCounter(historyCapacity)
+        {
+        }
+
+        // put一个新key：访问次数+1，满k次才允许进入缓存
+        bool admit(const Key &key)
+        {
+            size_t historyCount = touch(key);
+            if (historyCount >= _k)
+            {
+                _historyCounter.remove(key);
+                return true;
+            }
+            return false;
+        }
+
+        // get未命中同样算一次访问
+        void onMiss(const Key &key) { touch(key); }
+
+    private:
+        size_t touch(const Key &key)
+        {
+            size_t historyCount = 0;
+            _historyCounter.get(key, historyCount);
+            historyCount++;
+            _historyCounter.put(key, historyCount);
+            return historyCount;
+        }
+    };
+
+    // LFU：淘汰访问频次最低的元素，频次相同时淘汰其中最久未访问的
+    /*
+        每个访问频次一条双向链表（O(1) LFU），_minFreq记录当前最小频次。
+    */
+    template <typename Key>
+    class KLfuEviction
+    {
+    private:
+        struct FreqList
+        {
+            uint32_t head = KNil;
+            uint32_t tail = KNil;
+        };
+        vector<uint32_t> _prev;
+        vector<uint32_t> _next;
+        vector<size_t> _freq;                    // 每个slot的访问频次
+        unordered_map<size_t, FreqList> _lists; // 频次 -> 该频次的链表
+        size_t _minFreq = 0;
+
+    public:
+        explicit KLfuEviction(size_t capacity)
+            : _prev(capacity, KNil), _next(capacity, KNil), _freq(capacity, 0)
+        {
+        }
+
+        bool admit(const Key &) { return true; }
+        void onMiss(const Key &) {}
+
+        void onInsert(uint32_t id)
+        {
+            _freq[id] = 1;
+            pushBack(id);
+            _minFreq = 1; // 新元素的频次一定是最小的
+        }
+
+        void onAccess(uint32_t id)
+        {
+            size_t freq = _freq[id];
+            unlink(id);
+            if (freq == _minFreq && _lists.find(freq) == _lists.end())
+                _minFreq = freq + 1;
+            _freq[id] = freq + 1;
+            pushBack(id);
+        }
+
+        void onErase(uint32_t id) { unlink(id); }
+
+        uint32_t victim()
+        {
+            auto it = _lists.find(_minFreq);
+            if (it == _lists.end())
+            {
+                // 只有remove删掉了最小频次的最后一个元素时才会走到这里，重新找一次最小频次
+                if (_lists.empty())
+                    return KNil;
+                _minFreq = SIZE_MAX;
+                for (auto &entry : _lists)
+                    _minFreq = min(_minFreq, entry.first);
+                it = _lists.find(_minFreq);
+            }
+            return it->second.head;
+        }
+
+    private:
+        void pushBack(uint32_t id)
+        {
+            FreqList &list = _lists[_freq[id]];
+            _prev[id] = list.tail;
+            _next[id] = KNil;
+            if (list.tail != KNil)
+                _next[list.tail] = id;
+            else
+                list.head = id;
+            list.tail = id;
+        }
+
+        void unlink(uint32_t id)
+        {
+            auto it = _lists.find(_freq[id]);
+            FreqList &list = it->second;
+            if (_prev[id] != KNil)
+                _next[_prev[id]] = _next[id];
+            else
+                list.head = _next[id];
+            if (_next[id] != KNil)
+                _prev[_next[id]] = _prev[id];
+            else
+                list.tail = _prev[id];
+            _prev[id] = _next[id] = KNil;
+            if (list.head == KNil)
+                _lists.erase(it); // 这个频次已经没有元素了
+        }
+    };
+
+    // （4）KCache类
+    template <typename Key, typename Value,
+              template <typename> class Eviction = KLruEviction,
+              template <typename> class Index = KFlatIndex,
+              typename Locking = KMutexLock>
+    class KCache
+    {
+    public:
+        // 一个缓存节点（slot）
+        struct Slot
+        {
+            Key key;
+            Value value;
+        };
+
+    private:
+        size_t _capacity;
+        vector<Slot> _slots;      // 节点数组，下标就是slot id
+        vector<uint32_t> _freeIds; // remove/淘汰后空出来的slot id，插入时优先复用
+        Index<Key> _index;
+        Eviction<Key> _eviction;
+        Locking _lock;
+
+    public:
+        // 额外的参数原样转发给淘汰策略（例如KLruKEviction的historyCapacity和k）
+        template <typename... EvictionArgs>
+        explicit KCache(int capacity, EvictionArgs... evictionArgs)
+            : _capacity(capacity > 0 ? capacity : 0),
+              _index(_capacity),
+              _eviction(_capacity, evictionArgs...)
+        {
+            _slots.reserve(_capacity); // 一次分配好所有节点的内存
+        }
+
+        bool get(const Key &key, Value &value)
+        {
+            lock_guard<Locking> lock(_lock);
+            uint32_t id = _index.find(key, _slots);
+            if (id == KNil)
+            {
+                _eviction.onMiss(key);
+                return false;
+            }
+            _eviction.onAccess(id);
+            value = _slots[id].value;
+            return true;
+        }
+
+        Value get(const Key &key)
+        {
+            Value value{};
+            get(key, value);
+            return value; // 如果key不存在，则返回默认值
+        }
+
+        void put(const Key &key, const Value &value)
+        {
+            if (_capacity == 0)
+                return;
+            lock_guard<Locking> lock(_lock);
+            uint32_t id = _index.find(key, _slots);
+            if (id != KNil)
+            {
+                _slots[id].value = value;
+                _eviction.onAccess(id);
+                return;
+            }
+            if (!_eviction.admit(key))
+                return; // 淘汰策略不允许进入缓存（如LRU-K访问次数不足k次）
+            if (size() >= _capacity)
+                evict();
+            id = allocateSlot(key, value);
+            _index.insert(key, id, _slots);
+            _eviction.onInsert(id);
+        }
+
+        void remove(const Key &key)
+        {
+            lock_guard<Locking> lock(_lock);
+            uint32_t id = _index.find(key, _slots);
+            if (id != KNil)
+                eraseSlot(id);
+        }
+
+        size_t size() const { return _slots.size() - _freeIds.size(); }
+        size_t capacity() const { return _capacity; }
+
+    private:
+        uint32_t allocateSlot(const Key &key, const Value &value)
+        {
+            if (!_freeIds.empty())
+            {
+                uint32_t id = _freeIds.back();
+                _freeIds.pop_back();
+                _slots[id].key = key;
+                _slots[id].value = value;
+                return id;
+            }
+            _slots.push_back(Slot{key, value});
+            return static_cast<uint32_t>(_slots.size() - 1);
+        }
+
+        void evict()
+        {
+            uint32_t victim = _eviction.victim();
+            if (victim != KNil)
+                eraseSlot(victim);
+        }
+
+        void eraseSlot(uint32_t id)
+        {
+            _index.erase(_slots[id].key, _slots);
+            _eviction.onErase(id);
+            _slots[id].value = Value(); // 尽早释放value持有的资源（例如string的堆内存）
+            _freeIds.push_back(id);
+        }
+    };
+
+    // （5）KCacheAdapter类
+    // 把KCache包装成KICachePolicy，给按接口（虚函数）使用缓存的老代码
+    template <typename Key, typename Value,
+              template <typename> class Eviction = KLruEviction,
+              template <typename> class Index = KFlatIndex,
+              typename Locking = KMutexLock>
+    class KCacheAdapter : public KICachePolicy<Key, Value>
+    {
+    private:
+        KCache<Key, Value, Eviction, Index, Locking> _cache;
+
+    public:
+        template <typename... EvictionArgs>
+        explicit KCacheAdapter(int capacity, EvictionArgs... evictionArgs)
+            : _cache(capacity, evictionArgs...)
+        {
+        }
+
+        bool get(Key key, Value &value) override { return _cache.get(key, value); }
+        Value get(Key key) override { return _cache.get(key); }
+        void put(Key key, Value value) override { _cache.put(key, value); }
+        void remove(Key key) { _cache.remove(key); }
+    };
+}
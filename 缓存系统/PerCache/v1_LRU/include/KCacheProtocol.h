@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring> //memcpy
+#include <string>
+using namespace std;
+
+/*
+    percache-server使用的二进制协议（只在本机使用：Unix域套接字或回环TCP，所以直接使用本机字节序）
+
+    请求 = 8字节请求头 + 请求体
+        请求头：op(1字节) | 保留(1字节) | count(2字节，字段个数) | bodyLen(4字节，请求体长度)
+        请求体：count个字段，每个字段 = len(4字节) + len字节的数据
+            GET  key          count=1
+            SET  key value    count=2
+            DEL  key          count=1
+            MGET key1...keyN  count=N
+    响应 = 8字节响应头 + 响应体
+        响应头：status(1字节) | 保留(1字节) | count(2字节) | bodyLen(4字节)
+        响应体：count个字段，每个字段 = status(1字节) + len(4字节) + len字节的数据
+            GET   count=1（字段status表示是否命中）
+            SET / DEL  count=0
+            MGET  count=N，按请求中key的顺序
+    同一个连接上可以连续发送多个请求（流水线），服务器按顺序返回响应。
+*/
+namespace PerCache
+{
+    enum KCacheOp : uint8_t
+    {
+        KOpGet = 1,
+        KOpSet = 2,
+        KOpDel = 3,
+        KOpMGet = 4
+    };
+
+    enum KCacheStatus : uint8_t
+    {
+        KStatusOk = 0,
+        KStatusNotFound = 1,
+        KStatusError = 2
+    };
+
+    const size_t KHeaderSize = 8;
+    const size_t KMaxBodySize = 64 * 1024 * 1024; // 单个请求体最大64MB，超过视为协议错误
+
+    // 请求头/响应头
+    struct KCacheHeader
+    {
+        uint8_t code; // 请求中是op，响应中是status
+        uint8_t reserved;
+        uint16_t count;
+        uint32_t bodyLen;
+    };
+
+    inline void encodeHeader(char *out, uint8_t code, uint16_t count, uint32_t bodyLen)
+    {
+        KCacheHeader header{code, 0, count, bodyLen};
+        memcpy(out, &header, KHeaderSize);
+    }
+
+    inline KCacheHeader decodeHeader(const char *in)
+    {
+        KCacheHeader header;
+        memcpy(&header, in, KHeaderSize);
+        return header;
+    }
+
+    inline uint32_t readU32(const char *in)
+    {
+        uint32_t value;
+        memcpy(&value, in, sizeof(value));
+        return value;
+    }
+
+    // 从缓冲区开头切出一个帧（请求或响应）：数据不够一个完整的帧时返回KFrameIncomplete，等读到更多数据再试
+    // 流水线时缓冲区中可能有多个帧，每切出一个，调用者前进 KHeaderSize + header.bodyLen 字节再继续
+    enum KFrameResult
+    {
+        KFrameIncomplete,
+        KFrameComplete,
+        KFrameError // 请求体超过KMaxBodySize，连接应当关闭
+    };
+
+    inline KFrameResult nextFrame(const char *data, size_t len, KCacheHeader &header)
+    {
+        if (len < KHeaderSize)
+            return KFrameIncomplete;
+        header = decodeHeader(data);
+        if (header.bodyLen > KMaxBodySize)
+            return KFrameError; // 只看到请求头就能判断，不用等请求体收全
+        if (len - KHeaderSize < header.bodyLen)
+            return KFrameIncomplete;
+        return KFrameComplete;
+    }
+
+    // 按顺序读取请求体中的字段（len + 数据）
+    struct KFieldReader
+    {
+        const char *body;
+        uint32_t bodyLen;
+        size_t offset = 0;
+
+        // 读取下一个字段，越界返回false（协议错误）
+        bool next(const char *&data, uint32_t &len)
+        {
+            if (offset + sizeof(uint32_t) > bodyLen)
+                return false;
+            len = readU32(body + offset);
+            offset += sizeof(uint32_t);
+            if (len > bodyLen - offset)
+                return false;
+            data = body + offset;
+            offset += len;
+            return true;
+        }
+    };
+
+    // 往请求中追加一个字段
+    inline void appendField(string &out, const char *data, uint32_t len)
+    {
+        out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        out.append(data, len);
+    }
+
+    // 编码一个完整请求，追加到out（客户端使用）
+    inline void encodeRequest(string &out, KCacheOp op, const string *fields, uint16_t count)
+    {
+        uint32_t bodyLen = 0;
+        for (uint16_t i = 0; i < count; i++)
+            bodyLen += sizeof(uint32_t) + fields[i].size();
+        char header[KHeaderSize];
+        encodeHeader(header, op, count, bodyLen);
+        out.append(header, KHeaderSize);
+        for (uint16_t i = 0; i < count; i++)
+            appendField(out, fields[i].data(), fields[i].size());
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "KLruCache.h"
+
+namespace PerCache
+{
+    // KFcLruCache类：平坦合并（flat combining）方式执行的LRU缓存
+    /*
+        普通KLruCache在高并发下的问题：
+            每个线程都要轮流拿到_mutex，锁被占用时std::mutex会进入futex系统调用睡眠，交接一次锁就是一次唤醒；
+            而且每个线程拿到锁以后都要把链表头尾、哈希表的缓存行从上一个线程的CPU核心上拉过来。
+        平坦合并：
+            1.每个线程把自己的get/put请求写到一个发布槽（publication slot）里
+            2.谁用try_lock抢到了_mutex，谁就是合并者（combiner），一次扫描所有槽，把所有等待中的请求一起执行完
+              （链表和哈希表一直在合并者的缓存里是热的）
+            3.没抢到锁的线程不睡眠，只在自己的槽上自旋等待结果
+        合并者执行请求时持有的就是KLruCache的_mutex，所以remove、setCapacity等其他接口照常可以使用。
+    */
+    template <typename Key, typename Value>
+    class KFcLruCache : public KLruCache<Key, Value>
+    {
+    private:
+        // 槽的状态
+        enum SlotState
+        {
+            Idle = 0, // 空闲
+            Filling,  // 已被某个线程占用，正在填写请求
+            Pending,  // 请求已发布，等待合并者执行
+            Done      // 已执行完，结果已写回
+        };
+        enum OpType
+        {
+            OpGet,
+            OpPut
+        };
+        // 发布槽（按缓存行对齐，避免不同线程的槽伪共享）
+        struct alignas(64) Slot
+        {
+            atomic<int> state{Idle};
+            int op = OpGet;
+            const Key *key = nullptr;
+            Value *output = nullptr;      // get的结果写到这里（调用者的value）
+            const Value *input = nullptr; // put的value
+            bool result = false;
+        };
+
+        vector<Slot> _slots;
+        static const int _combinePasses = 2; // 合并者一次最多扫描几遍（扫描期间可能又有新请求发布）
+
+    public:
+        // slotNum：发布槽的个数，一般取线程数即可；线程多于槽数时，抢不到槽的线程直接走普通加锁路径
+        KFcLruCache(int capacity, int slotNum = 64)
+            : KLruCache<Key, Value>(capacity), _slots(slotNum > 0 ? slotNum : 1)
+        {
+        }
+
+        void put(Key key, Value value) override
+        {
+            execute(OpPut, key, nullptr, &value);
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            return execute(OpGet, key, &value, nullptr);
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+    private:
+        bool execute(int op, const Key &key, Value *output, const Value *input)
+        {
+            Slot &slot = _slots[threadIndex() % _slots.size()];
+            int expected = Idle;
+            if (!slot.state.compare_exchange_strong(expected, Filling, memory_order_acquire))
+            {
+                // 这个槽正被另一个线程使用（线程数多于槽数），退回普通加锁路径
+                if (op == OpGet)
+                    return KLruCache<Key, Value>::get(key, *output);
+                KLruCache<Key, Value>::put(key, *input);
+                return true;
+            }
+            slot.op = op;
+            slot.key = &key;
+            slot.output = output;
+            slot.input = input;
+            slot.state.store(Pending, memory_order_release); // 发布请求
+
+            int spins = 0;
+            while (slot.state.load(memory_order_acquire) != Done)
+            {
+                if (this->_mutex.try_lock())
+                {
+                    // 成为合并者，执行所有槽中的请求（包括自己的）
+                    combine();
+                    typename KLruCache<Key, Value>::Victims victims;
+                    this->takeVictims(victims);
+                    this->_mutex.unlock();
+                    this->releaseVictims(victims); // 延迟淘汰模式下，被淘汰的节点在锁外析构
+                }
+                else if (++spins >= 64)
+                {
+                    // 合并者可能正被抢占，让出CPU
+                    std::this_thread::yield();
+                    spins = 0;
+                }
+            }
+            bool result = slot.result;
+            slot.state.store(Idle, memory_order_release);
+            return result;
+        }
+
+        // 合并：扫描所有槽，执行等待中的请求（调用者已持有_mutex）
+        void combine()
+        {
+            for (int pass = 0; pass < _combinePasses; pass++)
+            {
+                bool found = false;
+                for (auto &slot : _slots)
+                {
+                    if (slot.state.load(memory_order_acquire) != Pending)
+                        continue;
+                    slot.result = apply(slot.op, *slot.key, slot.output, slot.input);
+                    slot.state.store(Done, memory_order_release);
+                    found = true;
+                }
+                if (!found)
+                    break;
+            }
+        }
+
+        bool apply(int op, const Key &key, Value *output, const Value *input)
+        {
+            if (op == OpGet)
+                return this->getNoLock(key, *output);
+            this->putNoLock(key, *input);
+            return true;
+        }
+
+        // 每个线程一个固定编号，用来选择自己的槽
+        static unsigned threadIndex()
+        {
+            static atomic<unsigned> nextIndex{0};
+            static thread_local unsigned index = nextIndex.fetch_add(1);
+            return index;
+        }
+    };
+}
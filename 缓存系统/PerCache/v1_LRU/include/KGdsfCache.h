@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "KICachePolicy.h"
+using namespace std;
+
+namespace PerCache
+{
+    // KGdsfCache类：GreedyDual-Size-Frequency，按"未命中的代价"淘汰
+    /*
+        LRU把所有元素一视同仁，但有的元素重新加载只要50微秒，有的要200毫秒。GDSF给每个元素一个优先级：
+            priority = L + frequency * cost / size
+                cost：重新加载这个元素的代价（put时给出，例如加载耗时的微秒数）
+                size：元素占用的容量（默认1，容量按size之和计算）
+                frequency：访问次数（put和每次命中都+1）
+                L：膨胀值，每淘汰一个元素，L更新为被淘汰元素的优先级
+        淘汰时删除优先级最低的元素。代价高、访问多、占用小的元素优先级高，留得更久；
+        L不断增长，很久没有被访问的元素的优先级相对新元素越来越低，最终也会被淘汰（相当于老化），所以不会有元素永远霸占缓存。
+        目标是让未命中的总代价最小，而不是未命中的次数最少。
+
+        实现：
+            元素存放在_entries数组中（槽位下标），空出来的槽位放进_freeSlots复用
+            _heap是按优先级排列的二叉小顶堆，存放槽位下标；每个元素记住自己在堆中的位置（heapPos），
+            所以更新任意元素的优先级、删除任意元素都是O(log n)，淘汰（取堆顶）也是O(log n)
+    */
+    template <typename Key, typename Value>
+    class KGdsfCache : public KICachePolicy<Key, Value>
+    {
+    private:
+        struct Entry
+        {
+            Key key;
+            Value value;
+            double cost;
+            size_t size;
+            uint64_t frequency;
+            double priority;
+            size_t heapPos; // 在_heap中的下标
+        };
+
+        size_t _capacity;                     // 容量（所有元素的size之和不超过它）
+        size_t _used = 0;                     // 已用容量
+        double _inflation = 0;                // L
+        vector<Entry> _entries;               // 槽位
+        vector<uint32_t> _freeSlots;          // 空闲槽位
+        vector<uint32_t> _heap;               // 按priority排列的小顶堆（槽位下标）
+        unordered_map<Key, uint32_t> _index;  // key -> 槽位
+        double _evictedCost = 0;              // 被淘汰元素的cost之和（观察用）
+        mutex _mutex;
+
+    public:
+        explicit KGdsfCache(size_t capacity)
+            : _capacity(capacity)
+        {
+        }
+
+        // 不带代价的put：cost = 1，size = 1（此时退化为LFU + 老化）
+        void put(Key key, Value value) override
+        {
+            put(key, value, 1.0, 1);
+        }
+
+        // 带代价的put：cost是重新加载的代价，size是占用的容量；size超过总容量的元素不会被缓存
+        void put(Key key, Value value, double cost, size_t size = 1)
+        {
+            if (size == 0)
+                size = 1;
+            lock_guard<mutex> lock(_mutex);
+            if (size > _capacity)
+                return;
+            auto it = _index.find(key);
+            if (it != _index.end())
+            {
+                // 已存在：更新value/cost/size，并按一次访问处理
+                Entry &entry = _entries[it->second];
+                _used = _used - entry.size + size;
+                entry.value = value;
+                entry.cost = cost;
+                entry.size = size;
+                touch(it->second);
+                evictUntilFits(0, it->second);
+                return;
+            }
+            evictUntilFits(size, UINT32_MAX);
+            uint32_t slot;
+            if (!_freeSlots.empty())
+            {
+                slot = _freeSlots.back();
+                _freeSlots.pop_back();
+                _entries[slot] = Entry{key, value, cost, size, 1, 0, 0};
+            }
+            else
+            {
+                slot = static_cast<uint32_t>(_entries.size());
+                _entries.push_back(Entry{key, value, cost, size, 1, 0, 0});
+            }
+            _entries[slot].priority = priorityOf(_entries[slot]);
+            _entries[slot].heapPos = _heap.size();
+            _heap.push_back(slot);
+            siftUp(_entries[slot].heapPos);
+            _index.emplace(key, slot);
+            _used += size;
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it == _index.end())
+                return false;
+            touch(it->second);
+            value = _entries[it->second].value;
+            return true;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        bool remove(Key key)
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it == _index.end())
+                return false;
+            uint32_t slot = it->second;
+            _index.erase(it);
+            eraseSlot(slot);
+            return true;
+        }
+
+        size_t size()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _index.size();
+        }
+
+        // 已用容量（size之和）
+        size_t usedCapacity()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _used;
+        }
+
+        // 当前的膨胀值L
+        double inflation()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _inflation;
+        }
+
+        // 被淘汰元素的cost之和
+        double evictedCost()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _evictedCost;
+        }
+
+    private:
+        double priorityOf(const Entry &entry) const
+        {
+            return _inflation + entry.frequency * entry.cost / entry.size;
+        }
+
+        // 一次访问：频率+1，按当前的L重新计算优先级
+        void touch(uint32_t slot)
+        {
+            Entry &entry = _entries[slot];
+            entry.frequency++;
+            entry.priority = priorityOf(entry);
+            // 一般只会变大（L只增不减），但put更新时cost可能变小、size可能变大，所以两个方向都调整
+            siftDown(entry.heapPos);
+            siftUp(_entries[slot].heapPos);
+        }
+
+        // 淘汰优先级最低的元素，直到放得下extra（keep是正在更新的槽位，不能淘汰它自己）
+        void evictUntilFits(size_t extra, uint32_t keep)
+        {
+            while (_used + extra > _capacity && !_heap.empty())
+            {
+                uint32_t victim = _heap[0];
+                if (victim == keep)
+                {
+                    if (_heap.size() == 1)
+                        break;
+                    // 正在更新的元素恰好在堆顶：淘汰它下面优先级更低的那个子节点
+                    victim = _heap.size() > 2 && less(2, 1) ? _heap[2] : _heap[1];
+                }
+                Entry &entry = _entries[victim];
+                _inflation = entry.priority; // L更新为被淘汰元素的优先级
+                _evictedCost += entry.cost;
+                _index.erase(entry.key);
+                eraseSlot(victim);
+            }
+        }
+
+        // 从堆中删除槽位并回收（调用者已经从_index中删除）
+        void eraseSlot(uint32_t slot)
+        {
+            size_t pos = _entries[slot].heapPos;
+            size_t last = _heap.size() - 1;
+            if (pos != last)
+            {
+                swapNodes(pos, last);
+                _heap.pop_back();
+                siftDown(pos);
+                siftUp(pos);
+            }
+            else
+            {
+                _heap.pop_back();
+            }
+            _used -= _entries[slot].size;
+            _entries[slot].key = Key(); // 释放key/value持有的资源
+            _entries[slot].value = Value();
+            _freeSlots.push_back(slot);
+        }
+
+        bool less(size_t a, size_t b) const
+        {
+            return _entries[_heap[a]].priority < _entries[_heap[b]].priority;
+        }
+
+        void swapNodes(size_t a, size_t b)
+        {
+            swap(_heap[a], _heap[b]);
+            _entries[_heap[a]].heapPos = a;
+            _entries[_heap[b]].heapPos = b;
+        }
+
+        void siftUp(size_t pos)
+        {
+            while (pos > 0)
+            {
+                size_t parent = (pos - 1) / 2;
+                if (!less(pos, parent))
+                    break;
+                swapNodes(pos, parent);
+                pos = parent;
+            }
+        }
+
+        void siftDown(size_t pos)
+        {
+            size_t n = _heap.size();
+            while (true)
+            {
+                size_t smallest = pos;
+                size_t left = 2 * pos + 1, right = left + 1;
+                if (left < n && less(left, smallest))
+                    smallest = left;
+                if (right < n && less(right, smallest))
+                    smallest = right;
+                if (smallest == pos)
+                    break;
+                swapNodes(pos, smallest);
+                pos = smallest;
+            }
+        }
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <algorithm> //sort
+using namespace std;
+
+namespace PerCache
+{
+    // 一个热点key的统计结果
+    template <typename Key>
+    struct KHotKey
+    {
+        Key key;
+        uint64_t count; // 估计的访问次数（已经乘上了采样率）
+        uint64_t error; // 估计误差上界：真实次数在[count - error, count]之间
+    };
+
+    // KHotKeySketch类：Space-Saving热点key统计
+    /*
+        Space-Saving算法：只保留capacity个计数器
+            key已经有计数器：count+1
+            还有空闲计数器：分配一个，count = 1
+            计数器用完了：替换掉count最小的那个计数器，新key继承它的count再+1，同时把继承的count记为error
+        任何访问次数超过 总次数/capacity 的key都一定会留在计数器里，所以它能找到真正的热点key。
+
+        为了让get/put路径上的开销只有几纳秒：
+            1.采样：每个线程每sampleRate次操作才记录一次（sampleRate取2的幂，判断只需要一次与运算）
+            2.try-lock：记录时用自旋锁的try_lock，锁正被别的线程占用就直接放弃这次采样，永远不会等待
+    */
+    template <typename Key>
+    class KHotKeySketch
+    {
+    private:
+        struct Counter
+        {
+            Key key;
+            uint64_t count;
+            uint64_t error;
+        };
+        size_t _capacity;
+        vector<Counter> _counters;
+        unordered_map<Key, size_t> _index; // key -> 计数器下标
+        atomic_flag _busy = ATOMIC_FLAG_INIT;
+
+    public:
+        explicit KHotKeySketch(size_t capacity)
+            : _capacity(capacity > 0 ? capacity : 1)
+        {
+            _counters.reserve(_capacity);
+            _index.reserve(_capacity * 2);
+        }
+
+        // 记录一次采样到的访问（拿不到锁就放弃）
+        void offer(const Key &key)
+        {
+            if (_busy.test_and_set(memory_order_acquire))
+                return;
+            auto it = _index.find(key);
+            if (it != _index.end())
+            {
+                _counters[it->second].count++;
+            }
+            else if (_counters.size() < _capacity)
+            {
+                _index[key] = _counters.size();
+                _counters.push_back(Counter{key, 1, 0});
+            }
+            else
+            {
+                // 替换count最小的计数器（capacity很小，线性扫描即可）
+                size_t minPos = 0;
+                for (size_t i = 1; i < _counters.size(); i++)
+                {
+                    if (_counters[i].count < _counters[minPos].count)
+                        minPos = i;
+                }
+                Counter &victim = _counters[minPos];
+                _index.erase(victim.key);
+                victim.key = key;
+                victim.error = victim.count;
+                victim.count++;
+                _index[key] = minPos;
+            }
+            _busy.clear(memory_order_release);
+        }
+
+        // 把当前所有计数器复制到out中
+        void collect(vector<KHotKey<Key>> &out)
+        {
+            while (_busy.test_and_set(memory_order_acquire))
+            {
+            }
+            for (auto &counter : _counters)
+                out.push_back(KHotKey<Key>{counter.key, counter.count, counter.error});
+            _busy.clear(memory_order_release);
+        }
+
+        // 合并多个sketch的统计结果，返回估计访问次数最多的n个key
+        /*
+            同一个key在多个sketch中出现时，count和error分别累加（不同分片的统计互不相交，一般只出现在一个sketch中）
+        */
+        static vector<KHotKey<Key>> merge(vector<KHotKey<Key>> &all, size_t n, uint64_t sampleRate)
+        {
+            unordered_map<Key, KHotKey<Key>> merged;
+            for (auto &hot : all)
+            {
+                auto it = merged.find(hot.key);
+                if (it == merged.end())
+                {
+                    merged.emplace(hot.key, hot);
+                }
+                else
+                {
+                    it->second.count += hot.count;
+                    it->second.error += hot.error;
+                }
+            }
+            vector<KHotKey<Key>> result;
+            result.reserve(merged.size());
+            for (auto &entry : merged)
+            {
+                KHotKey<Key> hot = entry.second;
+                hot.count *= sampleRate; // 换算成估计的真实访问次数
+                hot.error *= sampleRate;
+                result.push_back(hot);
+            }
+            sort(result.begin(), result.end(), [](const KHotKey<Key> &a, const KHotKey<Key> &b)
+                 { return a.count > b.count; });
+            if (result.size() > n)
+                result.erase(result.begin() + n, result.end());
+            return result;
+        }
+    };
+}
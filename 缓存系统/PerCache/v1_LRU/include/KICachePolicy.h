@@ -8,6 +8,9 @@ namespace PerCache
     class KICachePolicy
     {
     public:
+        using KeyType = Key;     // 让KShardedCache<Policy>这样只拿到具体策略类型的模板也能知道键值类型
+        using ValueType = Value;
+
         // 析构函数
         virtual ~KICachePolicy() {};
 
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib> //calloc、free
+#include <cstring> //memset
+#include <memory>
+#include <memory_resource>
+#include <new>     //bad_alloc
+#include <utility>
+using namespace std;
+
+namespace PerCache
+{
+    // KIncrementalHashMap类：渐进式扩容的哈希表（Redis dict的做法），KLruCache的索引
+    /*
+        unordered_map在元素个数超过 桶数 * 最大装载因子 时，由触发的那一次插入把所有元素重新散列到新的桶数组，
+        几百万个元素要上百毫秒，而KLruCache在这期间一直持有_mutex。这里改为：
+            reserve(n)：构造时按容量预先分配桶，容量之内不会扩容
+            需要扩容时（例如setCapacity调大、延迟淘汰允许超出容量）只分配两倍大小的新桶数组，
+            之后每次插入/删除搬运_rehashStep个旧桶、每次查找搬运1个旧桶，旧桶搬完后释放旧数组。
+            扩容期间查找、删除两个数组都要看，插入只进新数组。
+        新桶数组用calloc分配：大块内存由操作系统按需清零，分配本身不需要逐个初始化桶，所以没有任何一次操作是O(n)的。
+        每次插入至少搬运_rehashStep个桶，新数组装满（元素个数再翻倍）之前旧数组一定已经搬完，不会同时有三个数组。
+        只实现了KLruCache用到的接口：find返回节点指针（node->first是key，node->second是value，end()是nullptr），
+        emplace、erase(key)、erase(节点)、size、empty、reserve。
+        桶下标 = 哈希值乘以一个奇数常数后取高位（Fibonacci hashing），std::hash<int>这种恒等哈希也能分布均匀。
+        构造时可以传入一个pmr::memory_resource（例如统计内存用的KCountingResource），节点和桶数组都从它分配；
+        这时新桶数组需要自己清零（memset），不再是calloc的按需清零。
+    */
+    template <typename Key, typename Value, typename Hash, typename Equal>
+    class KIncrementalHashMap
+    {
+    public:
+        struct Node
+        {
+            Key first;
+            Value second;
+            size_t hash;
+            Node *next;
+        };
+        using iterator = Node *;
+
+    private:
+        struct Table
+        {
+            Node **buckets = nullptr;
+            size_t bits = 0; // 桶数 = 2^bits（buckets为空时为0）
+            size_t size = 0;
+
+            size_t bucketCount() const { return buckets != nullptr ? size_t(1) << bits : 0; }
+            size_t indexOf(size_t hash) const
+            {
+                return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+            }
+        };
+
+        static const size_t _rehashStep = 4;  // 每次插入/删除搬运的旧桶个数
+        static const size_t _minBits = 3;     // 最少8个桶
+
+        Table _tables[2];       // _tables[0]是当前数组；扩容期间_tables[1]是新数组
+        size_t _rehashIndex = 0; // 扩容期间旧数组中下一个要搬运的桶
+        bool _rehashing = false;
+        Hash _hash;
+        Equal _equal;
+        pmr::memory_resource *_resource; // 为空时用new/delete和calloc/free
+
+    public:
+        explicit KIncrementalHashMap(pmr::memory_resource *resource = nullptr) : _resource(resource) {}
+        KIncrementalHashMap(const KIncrementalHashMap &) = delete;
+        KIncrementalHashMap &operator=(const KIncrementalHashMap &) = delete;
+
+        ~KIncrementalHashMap()
+        {
+            for (Table &table : _tables)
+            {
+                for (size_t i = 0; i < table.bucketCount(); i++)
+                {
+                    Node *node = table.buckets[i];
+                    while (node != nullptr)
+                    {
+                        Node *next = node->next;
+                        destroyNode(node);
+                        node = next;
+                    }
+                }
+                freeBuckets(table);
+            }
+        }
+
+        // 预先分配能放下n个元素的桶（只在空表上一次性分配，否则按渐进式扩容处理）
+        void reserve(size_t n)
+        {
+            size_t bits = _minBits;
+            while ((size_t(1) << bits) < n)
+                bits++;
+            if (size() == 0 && !_rehashing)
+            {
+                freeBuckets(_tables[0]);
+                _tables[0].buckets = allocateBuckets(bits);
+                _tables[0].bits = bits;
+            }
+            else if (!_rehashing && bits > _tables[0].bits)
+            {
+                startRehash(bits);
+            }
+        }
+
+        iterator find(const Key &key)
+        {
+            if (_rehashing)
+                rehashStep(1);
+            size_t hash = _hash(key);
+            for (int t = 0; t <= (_rehashing ? 1 : 0); t++)
+            {
+                Table &table = _tables[t];
+                if (table.buckets == nullptr)
+                    continue;
+                for (Node *node = table.buckets[table.indexOf(hash)]; node != nullptr; node = node->next)
+                {
+                    if (node->hash == hash && _equal(node->first, key))
+                        return node;
+                }
+            }
+            return nullptr;
+        }
+
+        iterator end() const { return nullptr; }
+
+        // 插入（key已存在时不插入，返回false）
+        bool emplace(const Key &key, const Value &value)
+        {
+            if (find(key) != nullptr)
+                return false;
+            if (_rehashing)
+                rehashStep(_rehashStep);
+            else if (_tables[0].buckets == nullptr)
+                reserve(0);
+            else if (_tables[0].size >= _tables[0].bucketCount())
+                startRehash(_tables[0].bits + 1); // 装载因子到1时扩容为两倍
+            size_t hash = _hash(key);
+            Table &table = _tables[_rehashing ? 1 : 0];
+            size_t index = table.indexOf(hash);
+            table.buckets[index] = createNode(key, value, hash, table.buckets[index]);
+            table.size++;
+            return true;
+        }
+
+        bool erase(const Key &key)
+        {
+            return erase(find(key));
+        }
+
+        bool erase(iterator target)
+        {
+            if (target == nullptr)
+                return false;
+            for (int t = 0; t <= (_rehashing ? 1 : 0); t++)
+            {
+                Table &table = _tables[t];
+                if (table.buckets == nullptr)
+                    continue;
+                Node **link = &table.buckets[table.indexOf(target->hash)];
+                while (*link != nullptr && *link != target)
+                    link = &(*link)->next;
+                if (*link == target)
+                {
+                    *link = target->next;
+                    destroyNode(target);
+                    table.size--;
+                    if (_rehashing)
+                        rehashStep(_rehashStep);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 表空时释放桶数组（下一次插入重新分配最小的桶数组），用于不再使用的缓存归还按容量预先分配的内存
+        void releaseBuckets()
+        {
+            if (size() != 0 || _rehashing)
+                return;
+            freeBuckets(_tables[0]);
+            _tables[0].bits = 0;
+        }
+
+        size_t size() const { return _tables[0].size + _tables[1].size; }
+        bool empty() const { return size() == 0; }
+        size_t bucketCount() const { return _rehashing ? _tables[1].bucketCount() : _tables[0].bucketCount(); }
+        bool rehashing() const { return _rehashing; }
+
+    private:
+        Node **allocateBuckets(size_t bits)
+        {
+            size_t count = size_t(1) << bits;
+            if (_resource != nullptr)
+            {
+                void *buckets = _resource->allocate(count * sizeof(Node *), alignof(Node *));
+                memset(buckets, 0, count * sizeof(Node *));
+                return static_cast<Node **>(buckets);
+            }
+            Node **buckets = static_cast<Node **>(calloc(count, sizeof(Node *)));
+            if (buckets == nullptr)
+                throw bad_alloc();
+            return buckets;
+        }
+
+        void freeBuckets(Table &table)
+        {
+            if (table.buckets == nullptr)
+                return;
+            if (_resource != nullptr)
+                _resource->deallocate(table.buckets, table.bucketCount() * sizeof(Node *), alignof(Node *));
+            else
+                free(table.buckets);
+            table.buckets = nullptr;
+        }
+
+        Node *createNode(const Key &key, const Value &value, size_t hash, Node *next)
+        {
+            if (_resource == nullptr)
+                return new Node{key, value, hash, next};
+            void *memory = _resource->allocate(sizeof(Node), alignof(Node));
+            return new (memory) Node{key, value, hash, next};
+        }
+
+        void destroyNode(Node *node)
+        {
+            if (_resource == nullptr)
+            {
+                delete node;
+                return;
+            }
+            node->~Node();
+            _resource->deallocate(node, sizeof(Node), alignof(Node));
+        }
+
+        void startRehash(size_t bits)
+        {
+            _tables[1].buckets = allocateBuckets(bits);
+            _tables[1].bits = bits;
+            _tables[1].size = 0;
+            _rehashIndex = 0;
+            _rehashing = true;
+        }
+
+        // 搬运最多steps个非空的旧桶（连续的空桶最多跳过steps * 10个，保证每次的工作量有上限）
+        void rehashStep(size_t steps)
+        {
+            Table &from = _tables[0];
+            Table &to = _tables[1];
+            size_t emptyVisits = steps * 10;
+            size_t bucketCount = from.bucketCount();
+            while (steps > 0 && _rehashIndex < bucketCount)
+            {
+                Node *node = from.buckets[_rehashIndex];
+                if (node == nullptr)
+                {
+                    _rehashIndex++;
+                    if (--emptyVisits == 0)
+                        break;
+                    continue;
+                }
+                while (node != nullptr)
+                {
+                    Node *next = node->next;
+                    size_t index = to.indexOf(node->hash);
+                    node->next = to.buckets[index];
+                    to.buckets[index] = node;
+                    from.size--;
+                    to.size++;
+                    node = next;
+                }
+                from.buckets[_rehashIndex++] = nullptr;
+                steps--;
+            }
+            if (_rehashIndex == bucketCount)
+            {
+                // 搬运完成：新数组成为当前数组
+                freeBuckets(from);
+                _tables[0] = to;
+                _tables[1] = Table();
+                _rehashing = false;
+            }
+        }
+    };
+}
@@ -7,14 +7,41 @@
 #include <vector>
 #include <math.h>     //KHashLruCaches类的ceil函数
 #include <functional> ////KHashLruCaches类的hash函数
+#include <atomic>     //KHashLruCaches类的分片布局指针
+#include <condition_variable> //KHashLruCaches类的容量调配线程
+#include <chrono>
+#include <algorithm>
+#include <iterator>   //back_inserter
 #include "KICachePolicy.h"
+#include "KHotKeySketch.h"
+#include "KBloomFilter.h"
+#include "KReclaimer.h"
+#include "KIncrementalHashMap.h"
+#include "KMemoryBudget.h"
 using namespace std;
 
 namespace PerCache
 {
     // 前向声明 —— 为了KLruCache 在 LruNode 中声明为友元时可以找到定义
-    template <typename Key, typename Value>
+    template <typename Key, typename Value, typename Hasher = hash<Key>>
     class KLruCache;
+    template <typename Key, typename Value>
+    class KSlruCache; // 分段LRU（KSlruCache.h），同样直接操作LruNode的链表指针
+    template <typename Key, typename Value>
+    class K2QCache; // 2Q（K2QCache.h），Am段直接操作LruNode的链表指针
+
+    // 拷贝一个key/value：如果它使用polymorphic_allocator（pmr::string等），拷贝到resource上分配，否则普通拷贝
+    // 返回的是纯右值，用来初始化成员时直接构造在成员上，不会再拷贝一次（再拷贝会换回默认的内存资源）
+    template <typename T>
+    T copyWithResource(const T &item, pmr::memory_resource *resource)
+    {
+        if constexpr (uses_allocator<T, pmr::polymorphic_allocator<byte>>::value)
+        {
+            if (resource != nullptr)
+                return T(item, pmr::polymorphic_allocator<byte>(resource));
+        }
+        return item;
+    }
 
     // （1）LruNode类
     template <typename Key, typename Value>
@@ -23,86 +50,204 @@ namespace PerCache
         /*LruCache中的removeNode/insertNode等函数中需要直接操作LruNode的私有成员_prev、_next
         外部类访问一个类（LruNode）的私有成员，需要(在该类中即LruNode类)把外部类声明为友元
         */
-        friend class KLruCache<Key, Value>;
+        template <typename K, typename V, typename H>
+        friend class KLruCache; // 任意哈希函数的KLruCache
+        friend class KSlruCache<Key, Value>;
+        friend class K2QCache<Key, Value>;
 
     private:
         Key _key;                              // 键
         Value _value;                          // 值
         weak_ptr<LruNode<Key, Value>> _prev;   //_prev指向双向链表的前一个节点（前驱）
         shared_ptr<LruNode<Key, Value>> _next; //_next指向双向链表的后一个节点（后继）
+        size_t _hash = 0;                      // key的哈希值（插入时算好保存下来，哈希表扩容、淘汰时都不再重新计算）
+        uint32_t _epoch = 0;                   // 遍历纪元：节点插入时/被遍历到时的纪元，用于遍历时去重和跳过新插入的节点（见KLruCache::beginWalk）
+        bool _evicted = false;                 // 是否是因为容量被淘汰的（而不是remove/invalidateTag删除的），锁外通知淘汰监听器时用
+        // 标签不放在节点中（见KLruCache::_tagLinks），不用标签的缓存每个节点不为它多占内存
     public:
         // LruNode类的构造函数
         LruNode(Key key, Value value)
             : _key(key), _value(value)
         {
         }
+        // key/value在堆上的内存也从resource分配（见copyWithResource）
+        LruNode(const Key &key, const Value &value, pmr::memory_resource *resource)
+            : _key(copyWithResource(key, resource)), _value(copyWithResource(value, resource))
+        {
+        }
         Key getKey() const { return _key; }                   // 获取key——加上const表示无法修改对象的成员变量
         void setValue(const Value &value) { _value = value; } // 设置value值
         Value getValue() const { return _value; }             // 获取value值
     };
-    // （2）KLruCache类
+    // 哈希表的键：指向key的指针 + 预先算好的哈希值
+    /*
+        为什么不直接用Key作为哈希表的键？
+        KHashLruCaches选择分片时已经算过一次哈希值，如果分片内的unordered_map<Key, ...>查找时再算一次，
+        对很长的string key来说哈希的开销就翻倍了。用KeyRef作为键，哈希函数直接返回保存的哈希值，
+        查找时只需要把算好的哈希值带进来；哈希表扩容重新分桶时也直接用保存的哈希值，不会再对key做哈希。
+        指针指向节点中的_key，节点在哈希表中时一直存在，所以指针总是有效的。
+    */
+    template <typename Key>
+    struct KeyRef
+    {
+        const Key *key;
+        size_t hash;
+    };
+
+    template <typename Key>
+    struct KeyRefHash
+    {
+        size_t operator()(const KeyRef<Key> &ref) const { return ref.hash; }
+    };
+
+    template <typename Key>
+    struct KeyRefEqual
+    {
+        bool operator()(const KeyRef<Key> &a, const KeyRef<Key> &b) const
+        {
+            return a.hash == b.hash && *a.key == *b.key; // 先比较哈希值，不同就不用比较key（长string的比较也不便宜）
+        }
+    };
+
+    // 从缓存中取出的一个元素（见KLruCache::extractLeastRecent），带着哈希值和标签，搬到别的缓存时不用重新计算/丢失标签
     template <typename Key, typename Value>
+    struct KLruEntry
+    {
+        Key key;
+        Value value;
+        size_t hash;
+        bool tagged;
+        uint64_t tag;
+    };
+
+    // （2）KLruCache类
+    // Hasher：key的哈希函数（默认std::hash），KHashLruCaches用同一个哈希函数选择分片，再把哈希值传进来（见getHashed）
+    template <typename Key, typename Value, typename Hasher>
     class KLruCache : public KICachePolicy<Key, Value> // 继承 KICachePolicy类
     {
     public:
-        using LruNodeType = LruNode<Key, Value>;     // 节点
-        using NodePtr = shared_ptr<LruNodeType>;     // 管理一个节点的指针
-        using NodeMap = unordered_map<Key, NodePtr>; // 哈希表，键->指针（即某个节点）
+        using LruNodeType = LruNode<Key, Value>; // 节点
+        using NodePtr = shared_ptr<LruNodeType>; // 管理一个节点的指针
+        using NodeMap = KIncrementalHashMap<KeyRef<Key>, NodePtr, KeyRefHash<Key>, KeyRefEqual<Key>>; // 哈希表，键(的引用和哈希值)->指针（即某个节点），渐进式扩容
+        using Entry = KLruEntry<Key, Value>;
 
     private:
+        Hasher _hasher;     // 哈希函数
         int _capacity;      // Lru缓存容量(注意是哈希表而不是双向链表)
+        pmr::memory_resource *_resource; // 节点、索引和key/value的内存从这里分配（为空时用默认的new/delete，见构造函数）
         NodeMap _nodeMap;   // Lru哈希表
-        mutex _mutex;       // 互斥锁
         NodePtr _dummyHead; // shared_ptr指针管理的哨兵头节点
         NodePtr _dummyTail; // shared_ptr指针管理的哨兵尾节点
+
+        static const int _evictStep = 8; // setCapacity缩容后，每次操作最多顺带淘汰的元素个数
+
+        // 延迟淘汰（默认关闭，见enableDeferredEviction）
+        bool _deferEviction = false;   // 被淘汰的节点是否推迟到锁外析构
+        int _softOvershoot = 0;        // 允许超出容量的元素个数，超出后一次性淘汰一批
+        bool _backgroundReclaim = false; // 推迟的节点交给后台回收线程析构（否则在调用者线程中、锁外析构）
+        vector<NodePtr> _graveyard;    // 锁内摘下、等待在锁外析构的节点
+
+        // 分批遍历（见beginWalk）
+        mutex _walkMutex;                   // 同一时间只允许一个遍历（遍历期间一直持有，不影响get/put）
+        uint32_t _epoch = 0;                // 当前纪元，新插入的节点记为当前纪元
+        uint32_t _walkEpoch = 0;            // 正在进行的遍历开始时的纪元，纪元小于它的节点还没有被遍历
+        NodePtr _cursor;                    // 遍历游标：插入在链表中的一个标记节点，不在哈希表中
+        bool _snapshot = false;             // 是否是时间点快照模式
+        vector<pair<Key, Value>> _preserved; // 快照模式下，还没被遍历到就被修改/删除的节点的原值
+        static const size_t _walkScanFactor = 4; // walkStep一次最多看chunkSize * 4个节点（包括跳过的）
+
+        // 幽灵列表（默认关闭，见enableGhostList）：最近被淘汰的key的哈希值
+        size_t _ghostCapacity = 0;              // 最多记住多少个被淘汰的key
+        vector<size_t> _ghostRing;              // 按淘汰顺序循环存放哈希值
+        size_t _ghostPos = 0;                   // 下一个写入位置
+        size_t _ghostSize = 0;                  // _ghostRing中已经写入的个数
+        unordered_map<size_t, uint32_t> _ghosts; // 哈希值 -> 在_ghostRing中出现的次数
+        uint64_t _ghostHits = 0;                // get未命中、但key在幽灵列表中的次数
+
+        // 标签（见put(key, value, tag)）：同一个标签的节点串成一个双向链表，链表的指针放在_tagLinks中，只有带标签的节点在表中
+        // 节点由哈希表中的shared_ptr管理，离开缓存前一定会先从标签链表中摘下，所以用裸指针
+        struct TagLink
+        {
+            uint64_t tag;
+            LruNodeType *prev;
+            LruNodeType *next;
+        };
+        unordered_map<uint64_t, LruNodeType *> _tagIndex;            // 标签 -> 带这个标签的节点链表的第一个节点（没有节点的标签不在表中）
+        unordered_map<const LruNodeType *, TagLink> _tagLinks;      // 带标签的节点 -> 它的标签和前后节点
+
+        shared_ptr<const function<void(const Key &, const Value &)>> _evictionListener; // 淘汰监听器（见setEvictionListener），releaseVictims在锁外使用锁内取到的副本
     public:
         // KLruCache类的构造函数
-        KLruCache(int capacity)
-            : _capacity(capacity)
+        // resource：可选的内存资源（例如KCountingResource），用来统计这个缓存实际占用的字节数；
+        // 节点和shared_ptr控制块、索引的节点和桶数组都从它分配，key/value是pmr类型时它们在堆上的内存也从它分配
+        KLruCache(int capacity, pmr::memory_resource *resource = nullptr)
+            : _capacity(capacity), _resource(resource), _nodeMap(resource)
         {
             initializeList(); // 构建双向链表（初始化哨兵头尾节点）
+            _nodeMap.reserve(capacity > 0 ? capacity : 0); // 按容量预先分配桶：容量之内的插入不会触发扩容
             /*注意：不需要显式初始化：
                 std::mutex 是 RAII 类型，声明时已经自动初始化。
                 nodeMap_(非指针成员变量会在对象构造时自动调用默认构造函数)自动初始化为空哈希表。
            */
         }
 
+        // 析构时先逐个断开_next链：否则链表中每个节点的析构会递归析构它的后继，元素很多时会栈溢出
+        ~KLruCache()
+        {
+            NodePtr node = _dummyHead;
+            while (node != nullptr)
+            {
+                NodePtr next = node->_next;
+                node->_next = nullptr;
+                node = next;
+            }
+        }
+
         // put添加缓存(更新哈希表和双向链表)
         void put(Key key, Value value) override
         {
-            // 如果容量小于等于0，返回（说明参数错误）
-            if (_capacity <= 0)
-                return;
-            // lock_guard加锁
-            lock_guard<mutex> lock(_mutex);
-            // 如果查找到key，则更新对应的value
-            auto it = _nodeMap.find(key); // it是一个迭代器
-            if (it != _nodeMap.end())
+            putHashed(key, _hasher(key), value);
+        }
+
+        // 带标签的put（比如标签是租户ID）：之后可以用invalidateTag一次删除带这个标签的所有元素
+        // 已经存在的key会改成新的标签；不带标签的put不会改变已有元素的标签
+        void put(Key key, Value value, uint64_t tag)
+        {
+            putHashed(key, _hasher(key), value, &tag);
+        }
+
+        // 已经算好哈希值的put（hash必须是Hasher算出来的值），tag为nullptr表示不带标签
+        void putHashed(const Key &key, size_t hash, const Value &value, const uint64_t *tag = nullptr)
+        {
+            Victims victims;
             {
-                updateExistingNode(it->second, value); // shared_ptr指针，值
-                return;
+                // lock_guard加锁
+                lock_guard<mutex> lock(_mutex);
+                putNoLock(key, hash, value, tag);
+                takeVictims(victims);
+                // 离开作用域自动解锁
             }
-
-            // 否则（代表没有找到对应的key），直接插入这个节点
-            addNewNode(key, value);
-            // 离开作用域自动解锁
+            releaseVictims(victims); // 延迟淘汰模式下，被淘汰的节点在锁外析构
         }
 
         // get查询哈希表中是否存在键，并使用输出参数value填充对应的值；若不存在返回fasle
         bool get(Key key, Value &value) override
         {
-            lock_guard<mutex> lock(_mutex);
-            auto it = _nodeMap.find(key);
-            if (it != _nodeMap.end())
+            return getHashed(key, _hasher(key), value);
+        }
+
+        // 已经算好哈希值的get
+        bool getHashed(const Key &key, size_t hash, Value &value)
+        {
+            Victims victims;
+            bool found;
             {
-                // 查询节点后将该节点移动到最新位置
-                moveToMostRecent(it->second);
-                // 并把查询结果更新到输出参数value  —— it->second是节点，getValue是调用了LruNode类中的getValue方法
-                value = it->second->getValue();
-                return true;
+                lock_guard<mutex> lock(_mutex);
+                found = getNoLock(key, hash, value);
+                takeVictims(victims); // 缩容期间get也会顺带淘汰
             }
-            // 否则，如果没有在哈希表中查询到该key,返回false
-            return false;
+            releaseVictims(victims);
+            return found;
         }
 
         Value get(Key key) override
@@ -114,13 +259,459 @@ namespace PerCache
         // 删除指定元素（到双向链表和哈希表）
         void remove(Key key)
         {
-            std::lock_guard<std::mutex> lock(_mutex);
-            auto it = _nodeMap.find(key);
+            removeHashed(key, _hasher(key));
+        }
+
+        // 已经算好哈希值的remove
+        void removeHashed(const Key &key, size_t hash)
+        {
+            NodePtr removed; // 在锁外析构
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _nodeMap.find(KeyRef<Key>{&key, hash});
+                if (it != _nodeMap.end())
+                {
+                    removed = it->second;
+                    preserveForSnapshot(removed);
+                    untagNode(removed.get());
+                    removeNode(it->second); // 双向链表中删除该节点
+                    _nodeMap.erase(it);     // 哈希表中删除key-value
+                }
+            }
+        }
+
+        // 仅当key不存在时插入（已存在则保留原值，返回false）
+        bool putIfAbsent(Key key, Value value)
+        {
+            return putIfAbsentHashed(key, _hasher(key), value);
+        }
+
+        // 已经算好哈希值的putIfAbsent
+        bool putIfAbsentHashed(const Key &key, size_t hash, const Value &value, const uint64_t *tag = nullptr)
+        {
+            Victims victims;
+            {
+                lock_guard<mutex> lock(_mutex);
+                if (_capacity <= 0 || _nodeMap.find(KeyRef<Key>{&key, hash}) != _nodeMap.end())
+                    return false;
+                LruNodeType *node = addNewNode(key, hash, value);
+                if (tag != nullptr)
+                    tagNode(node, *tag);
+                trimToCapacity();
+                takeVictims(victims);
+            }
+            releaseVictims(victims);
+            return true;
+        }
+
+        // 从最久未使用的一端取出最多maxCount个元素（从缓存中删除，连同哈希值和标签追加到out中），返回取出的个数
+        size_t extractLeastRecent(size_t maxCount, vector<Entry> &out)
+        {
+            Victims victims;
+            size_t count = 0;
+            {
+                lock_guard<mutex> lock(_mutex);
+                while (count < maxCount && !_nodeMap.empty())
+                {
+                    auto RealHead = leastRecentNode();
+                    auto link = _tagLinks.find(RealHead.get());
+                    bool tagged = link != _tagLinks.end();
+                    out.push_back(Entry{RealHead->_key, RealHead->_value, RealHead->_hash, tagged, tagged ? link->second.tag : 0});
+                    evictLeastRecent(false); // 取出不算淘汰，不通知监听器
+                    count++;
+                }
+                takeVictims(victims);
+            }
+            releaseVictims(victims);
+            return count;
+        }
+
+        // 按最久未使用的顺序淘汰最多maxCount个元素（和容量淘汰一样通知淘汰监听器），返回淘汰的个数
+        // KHashLruCaches超出内存预算时用它从占用最多的分片淘汰
+        size_t evict(size_t maxCount)
+        {
+            Victims victims;
+            size_t count = 0;
+            {
+                lock_guard<mutex> lock(_mutex);
+                for (; count < maxCount && !_nodeMap.empty(); count++)
+                    evictLeastRecent();
+                takeVictims(victims);
+            }
+            releaseVictims(victims);
+            return count;
+        }
+
+        // 缓存已经空了时释放索引按容量预先分配的桶数组（KHashLruCaches重新分片后，迁空的旧分片用它归还内存）
+        void releaseIndexIfEmpty()
+        {
+            lock_guard<mutex> lock(_mutex);
+            _nodeMap.releaseBuckets();
+        }
+
+        // 运行时修改容量
+        /*
+            扩容直接生效；缩容时不会在这里一次性淘汰掉多出来的所有元素（可能有上百万个），
+            只淘汰一小步，剩下的分摊到之后的每次put/get中（每次最多_evictStep个），任何一次调用都不会长时间持锁。
+        */
+        void setCapacity(int capacity)
+        {
+            Victims victims;
+            {
+                lock_guard<mutex> lock(_mutex);
+                _capacity = capacity;
+                if (capacity > 0)
+                    _nodeMap.reserve(capacity); // 调大时开始渐进式扩容（只分配新桶数组，搬运分摊到之后的操作中）
+                trimToCapacity();
+                takeVictims(victims);
+            }
+            releaseVictims(victims);
+        }
+
+        // 开启延迟淘汰
+        /*
+            默认情况下，put触发淘汰时，写入者在持有_mutex的情况下析构被淘汰的节点（包括其中的value，可能要释放很大的内存），
+            其他所有请求都要等它。淘汰风暴时这就是put的长尾延迟。
+            开启后：
+                1.允许元素个数超出容量softOvershoot个，超出后一次淘汰一批（回到容量以下），而不是每次put淘汰一个
+                2.锁内只把节点从链表和哈希表中摘下来，节点的析构推迟到释放锁之后：
+                  backgroundReclaim为true时交给后台回收线程（KReclaimer），否则由调用者线程在锁外析构
+        */
+        void enableDeferredEviction(int softOvershoot, bool backgroundReclaim = true)
+        {
+            lock_guard<mutex> lock(_mutex);
+            _deferEviction = true;
+            _softOvershoot = softOvershoot > 0 ? softOvershoot : 0;
+            _backgroundReclaim = backgroundReclaim;
+        }
+
+        int getCapacity()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _capacity;
+        }
+
+        // 删除带有tag标签的所有元素，返回删除的个数
+        /*
+            通过标签链表直接找到这些节点，开销只和带这个标签的元素个数有关，不会扫描整个缓存。
+            batchSize为0时在一次加锁内删完；大于0时每删除batchSize个就释放一次锁，让其它请求插进来
+            （删除期间新写入的带这个标签的元素也会被删除）。被删除的节点都在锁外析构。
+        */
+        size_t invalidateTag(uint64_t tag, size_t batchSize = 0)
+        {
+            size_t removed = 0;
+            bool more = true;
+            while (more)
+            {
+                Victims victims;
+                {
+                    lock_guard<mutex> lock(_mutex);
+                    size_t count = 0;
+                    while (true)
+                    {
+                        auto it = _tagIndex.find(tag);
+                        if (it == _tagIndex.end())
+                        {
+                            more = false;
+                            break;
+                        }
+                        if (batchSize > 0 && count == batchSize)
+                            break;
+                        LruNodeType *node = it->second;
+                        auto found = _nodeMap.find(KeyRef<Key>{&node->_key, node->_hash});
+                        NodePtr victim = found->second;
+                        preserveForSnapshot(victim);
+                        untagNode(node);
+                        removeNode(victim);
+                        _nodeMap.erase(found);
+                        victims.nodes.push_back(move(victim));
+                        count++;
+                    }
+                    removed += count;
+                    takeVictims(victims); // 在锁内记下回收方式
+                }
+                releaseVictims(victims);
+            }
+            return removed;
+        }
+
+        // 设置淘汰监听器：元素因为容量不够被淘汰时调用listener(key, value)
+        /*
+            监听器在锁外调用（被淘汰的节点先放进_graveyard，和延迟淘汰的方式一样），在触发淘汰的那个put/get的线程中，
+            这个put/get返回之前。所以监听器里可以做慢操作（例如把脏数据写回存储，见KWriteBackCache），
+            也可以再访问这个缓存，不会死锁。remove、invalidateTag删除的元素和重新分片迁移走的元素不算淘汰，不会通知。
+        */
+        void setEvictionListener(function<void(const Key &, const Value &)> listener)
+        {
+            auto shared = listener ? make_shared<const function<void(const Key &, const Value &)>>(move(listener)) : nullptr;
+            lock_guard<mutex> lock(_mutex);
+            _evictionListener = move(shared);
+        }
+
+        // 开启幽灵列表：记住最近被淘汰的ghostCapacity个key（只存哈希值，不存key/value）
+        /*
+            get未命中时如果key在幽灵列表中，说明容量再大ghostCapacity个就能命中，
+            这个次数就是"多给这个缓存ghostCapacity个容量能多得到的命中数"（边际收益），
+            KHashLruCaches用它在分片之间调配容量（见KHashLruCaches::rebalance）。
+        */
+        void enableGhostList(size_t ghostCapacity)
+        {
+            lock_guard<mutex> lock(_mutex);
+            _ghostCapacity = ghostCapacity;
+            _ghostRing.assign(ghostCapacity, 0);
+            _ghostPos = 0;
+            _ghostSize = 0;
+            _ghosts.clear();
+            _ghostHits = 0;
+        }
+
+        // 取出并清零幽灵列表命中次数
+        uint64_t takeGhostHits()
+        {
+            lock_guard<mutex> lock(_mutex);
+            uint64_t hits = _ghostHits;
+            _ghostHits = 0;
+            return hits;
+        }
+
+        // 分批遍历所有元素：fn(key, value)
+        /*
+            不会在整个遍历期间持有_mutex：每次只在锁内从游标处往后取chunkSize个节点（拷贝出来），
+            释放锁以后再对这一批调用fn，然后把游标移到这一批之后，直到链表末尾。所以遍历时请求的延迟不会突增。
+            从最久未使用往最新的方向遍历，游标是一个插在链表中的标记节点，链表怎么修改它都还在原来的位置。
+            snapshot为false（弱一致）：
+                遍历开始后插入的元素不会被遍历到；遍历开始时已有的元素，只要没有被删除，恰好被遍历一次
+                （被get移到链表尾部的元素也不会重复遍历）；遍历到之前被修改的元素，遍历到的是修改后的值
+            snapshot为true（写时复制的时间点快照）：
+                遍历结果恰好是调用forEach那一刻缓存的内容。遍历期间，写入者在修改或删除一个还没被遍历到的元素之前，
+                先把它的原值保存下来，由遍历者取走。只有被修改的元素需要复制，不会一次性复制整个缓存。
+        */
+        template <typename Fn>
+        void forEach(Fn fn, size_t chunkSize = 64, bool snapshot = false)
+        {
+            WalkGuard walk(*this, snapshot); // fn抛出异常时也会结束遍历
+            vector<pair<Key, Value>> chunk;
+            bool more = true;
+            while (more)
+            {
+                chunk.clear();
+                more = walkStep(chunkSize, chunk);
+                for (auto &entry : chunk)
+                    fn(entry.first, entry.second); // 锁外调用
+            }
+        }
+
+        // 时间点快照：导出调用时刻的全部内容
+        vector<pair<Key, Value>> snapshot(size_t chunkSize = 64)
+        {
+            vector<pair<Key, Value>> out;
+            forEach([&out](const Key &key, const Value &value)
+                    { out.emplace_back(key, value); },
+                    chunkSize, true);
+            return out;
+        }
+
+        // 遍历的三个步骤（forEach就是由它们组成的；KHashLruCaches用它们先开始所有分片的快照，再逐个分片遍历）
+        // beginWalk和endWalk必须成对调用，中间会调用用户的fn，所以通过WalkGuard调用，fn抛出异常时也能结束遍历
+        // 1.开始遍历：插入游标，纪元+1
+        void beginWalk(bool snapshot)
+        {
+            NodePtr cursor = make_shared<LruNodeType>(Key(), Value()); // 先分配游标：分配失败时还没有持有_walkMutex
+            _walkMutex.lock(); // 等待上一个遍历结束，直到endWalk才释放
+            lock_guard<mutex> lock(_mutex);
+            _walkEpoch = ++_epoch;
+            _snapshot = snapshot;
+            _cursor = cursor;
+            // 游标插在哨兵头节点之后
+            _cursor->_next = _dummyHead->_next;
+            _cursor->_prev = _dummyHead;
+            _dummyHead->_next->_prev = _cursor;
+            _dummyHead->_next = _cursor;
+        }
+
+        // 2.从游标处往后取最多chunkSize个元素追加到out中（快照模式下还有被保存下来的原值），返回是否还有剩余
+        /*
+            遍历期间插入的节点、已经遍历过又被get/put移到尾部的节点都要跳过，它们可能有很多，
+            所以一次最多看chunkSize * _walkScanFactor个节点（包括跳过的），持锁时间和chunkSize成正比，不会是O(n)。
+        */
+        bool walkStep(size_t chunkSize, vector<pair<Key, Value>> &out)
+        {
+            lock_guard<mutex> lock(_mutex);
+            for (auto &entry : _preserved)
+                out.push_back(move(entry));
+            _preserved.clear();
+            size_t count = 0;
+            size_t scanned = 0;
+            size_t scanLimit = max<size_t>(chunkSize, 1) * _walkScanFactor;
+            NodePtr node = _cursor->_next;
+            while (node != _dummyTail && count < chunkSize && scanned < scanLimit)
+            {
+                scanned++;
+                if (node->_epoch < _walkEpoch)
+                {
+                    out.emplace_back(node->_key, node->_value);
+                    node->_epoch = _walkEpoch; // 标记为已遍历
+                    count++;
+                }
+                node = node->_next;
+            }
+            // 把游标移到node之前（node是下一次要看的第一个节点）
+            removeNode(_cursor);
+            auto prev = node->_prev.lock();
+            prev->_next = _cursor;
+            _cursor->_prev = prev;
+            _cursor->_next = node;
+            node->_prev = _cursor;
+            return node != _dummyTail;
+        }
+
+        // 3.结束遍历：移除游标
+        void endWalk()
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                removeNode(_cursor);
+                _cursor = nullptr;
+                _snapshot = false;
+                _preserved.clear();
+            }
+            _walkMutex.unlock();
+        }
+
+        // 构造时beginWalk，析构时（或者提前调用finish时）endWalk
+        class WalkGuard
+        {
+        private:
+            KLruCache *_cache;
+
+        public:
+            WalkGuard(KLruCache &cache, bool snapshot) : _cache(&cache) { cache.beginWalk(snapshot); }
+            WalkGuard(const WalkGuard &) = delete;
+            WalkGuard &operator=(const WalkGuard &) = delete;
+            ~WalkGuard() { finish(); }
+
+            void finish()
+            {
+                if (_cache != nullptr)
+                    _cache->endWalk();
+                _cache = nullptr;
+            }
+        };
+
+        // 当前元素个数（缩容期间可能暂时大于容量）
+        size_t size()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _nodeMap.size();
+        }
+
+    protected:
+        mutex _mutex; // 互斥锁（派生类可以用它实现不同的加锁方式，见KFcLruCache）
+
+        // 不加锁的put，调用者必须已经持有_mutex
+        void putNoLock(const Key &key, const Value &value)
+        {
+            putNoLock(key, _hasher(key), value);
+        }
+
+        void putNoLock(const Key &key, size_t hash, const Value &value, const uint64_t *tag = nullptr)
+        {
+            // 如果容量小于等于0，返回（说明参数错误）。_capacity可能被setCapacity修改，所以在锁内读取
+            if (_capacity <= 0)
+            {
+                trimToCapacity();
+                return;
+            }
+            // 如果查找到key，则更新对应的value
+            auto it = _nodeMap.find(KeyRef<Key>{&key, hash}); // it是一个迭代器
+            if (it != _nodeMap.end())
+            {
+                updateExistingNode(it->second, value); // shared_ptr指针，值
+                if (tag != nullptr)
+                    tagNode(it->second.get(), *tag);
+                trimToCapacity();
+                return;
+            }
+
+            // 否则（代表没有找到对应的key），直接插入这个节点
+            LruNodeType *node = addNewNode(key, hash, value);
+            if (tag != nullptr)
+                tagNode(node, *tag);
+            trimToCapacity();
+        }
+
+        // 一次操作在锁内取出的被淘汰节点，连同锁内读到的监听器和回收方式（见takeVictims）
+        struct Victims
+        {
+            vector<NodePtr> nodes;
+            shared_ptr<const function<void(const Key &, const Value &)>> listener;
+            bool background = false;
+        };
+
+        // 取出锁内摘下的节点（调用者必须已经持有_mutex），之后在锁外调用releaseVictims
+        /*
+            淘汰监听器和回收方式也在锁内取一份：enableDeferredEviction/setEvictionListener在锁内修改它们，
+            releaseVictims在锁外运行，不能再直接读成员。
+        */
+        void takeVictims(Victims &victims)
+        {
+            if (!_graveyard.empty())
+            {
+                if (victims.nodes.empty())
+                    victims.nodes.swap(_graveyard);
+                else
+                {
+                    move(_graveyard.begin(), _graveyard.end(), back_inserter(victims.nodes));
+                    _graveyard.clear();
+                }
+            }
+            if (!victims.nodes.empty())
+            {
+                victims.listener = _evictionListener;
+                victims.background = _backgroundReclaim;
+            }
+        }
+
+        // 在锁外析构被淘汰的节点，或交给后台回收线程
+        void releaseVictims(Victims &victims)
+        {
+            if (victims.nodes.empty())
+                return;
+            if (victims.listener)
+            {
+                for (auto &victim : victims.nodes)
+                {
+                    if (victim->_evicted)
+                        (*victims.listener)(victim->_key, victim->_value);
+                }
+            }
+            if (victims.background)
+                KReclaimer::shared().post(make_shared<vector<NodePtr>>(move(victims.nodes)));
+            victims.nodes.clear(); // 否则就在这里（锁外）析构
+        }
+
+        // 不加锁的get，调用者必须已经持有_mutex
+        bool getNoLock(const Key &key, Value &value)
+        {
+            return getNoLock(key, _hasher(key), value);
+        }
+
+        bool getNoLock(const Key &key, size_t hash, Value &value)
+        {
+            trimToCapacity();
+            auto it = _nodeMap.find(KeyRef<Key>{&key, hash});
             if (it != _nodeMap.end())
             {
-                removeNode(it->second); // 双向链表中删除该节点
-                _nodeMap.erase(it);     // 哈希表中删除key-value
+                // 查询节点后将该节点移动到最新位置
+                moveToMostRecent(it->second);
+                // 并把查询结果更新到输出参数value  —— it->second是节点，getValue是调用了LruNode类中的getValue方法
+                value = it->second->getValue();
+                return true;
             }
+            // 否则，如果没有在哈希表中查询到该key,返回false
+            if (_ghostCapacity > 0 && _ghosts.count(hash) != 0)
+                _ghostHits++;
+            return false;
         }
 
     private:
@@ -136,6 +727,7 @@ namespace PerCache
         // 更新节点位置
         void updateExistingNode(NodePtr node, const Value &value)
         {
+            preserveForSnapshot(node);
             // 更新节点的value
             node->setValue(value);
             // 将节点移动到链表尾部（最新位置）
@@ -143,16 +735,25 @@ namespace PerCache
         }
 
         // 插入节点(更新哈希表和双向链表)
-        void addNewNode(const Key &key, const Value &value)
+        LruNodeType *addNewNode(const Key &key, size_t hash, const Value &value)
         {
             // 限制哈希表大小，通过O（1）得到元素数量。（而如果限制双向链表大小，遍历链表需要O（n））
-            if (_nodeMap.size() >= _capacity)
+            if (_nodeMap.size() >= static_cast<size_t>(_capacity + _softOvershoot))
             {
-                evictLeastRecent(); // 驱逐最少访问，给哈希表留出容量
+                // 驱逐最少访问，给哈希表留出容量；允许超出容量时一次淘汰一批（最多softOvershoot+1个）
+                for (int i = 0; i <= _softOvershoot && _nodeMap.size() >= static_cast<size_t>(_capacity); i++)
+                {
+                    evictLeastRecent();
+                }
             }
-            NodePtr newNode = make_shared<LruNodeType>(key, value); // 创建节点（这对key-value）
+            NodePtr newNode = _resource != nullptr
+                                  ? allocate_shared<LruNodeType>(pmr::polymorphic_allocator<LruNodeType>(_resource), key, value, _resource)
+                                  : make_shared<LruNodeType>(key, value); // 创建节点（这对key-value）
+            newNode->_hash = hash;
+            newNode->_epoch = _epoch;                               // 遍历进行中插入的节点不会被这次遍历看到
             insertNode(newNode);                                    // 双向链表中插入该节点
-            _nodeMap[key] = newNode;                                // 哈希表中插入这个节点
+            _nodeMap.emplace(KeyRef<Key>{&newNode->_key, hash}, newNode); // 哈希表中插入这个节点（键指向节点自己的_key）
+            return newNode.get();
         }
 
         // 将节点移到最新位置
@@ -194,11 +795,115 @@ namespace PerCache
         }
 
         // 驱逐最少访问（删除哈希表key和删除链表头节点）
-        void evictLeastRecent()
+        void evictLeastRecent(bool notify = true)
         {
-            auto RealHead = _dummyHead->_next;
+            auto RealHead = leastRecentNode();
+            preserveForSnapshot(RealHead);
+            untagNode(RealHead.get());
             removeNode(RealHead);               // 在链表中删除头节点
-            _nodeMap.erase(RealHead->getKey()); // 在哈希表中删除key-value(erase)
+            _nodeMap.erase(KeyRef<Key>{&RealHead->_key, RealHead->_hash}); // 在哈希表中删除key-value(erase)，用保存的哈希值
+            if (_ghostCapacity > 0)
+                rememberGhost(RealHead->_hash);
+            if (notify && _evictionListener)
+            {
+                RealHead->_evicted = true;
+                _graveyard.push_back(move(RealHead)); // 留到锁外通知监听器
+            }
+            else if (_deferEviction)
+            {
+                _graveyard.push_back(move(RealHead)); // 延迟淘汰：节点留到锁外再析构
+            }
+        }
+
+        // 给节点打上标签：挂到这个标签链表的头部（已经有别的标签就先摘下来）
+        void tagNode(LruNodeType *node, uint64_t tag)
+        {
+            auto found = _tagLinks.find(node);
+            if (found != _tagLinks.end())
+            {
+                if (found->second.tag == tag)
+                    return;
+                untagNode(node);
+            }
+            LruNodeType *&head = _tagIndex[tag];
+            if (head != nullptr)
+                _tagLinks[head].prev = node;
+            _tagLinks[node] = TagLink{tag, nullptr, head};
+            head = node;
+        }
+
+        // 从标签链表中摘下节点（没有标签时什么都不做），链表空了就删掉这个标签
+        void untagNode(LruNodeType *node)
+        {
+            if (_tagLinks.empty()) // 不用标签的缓存：淘汰、删除时只多这一次判断
+                return;
+            auto found = _tagLinks.find(node);
+            if (found == _tagLinks.end())
+                return;
+            TagLink link = found->second;
+            _tagLinks.erase(found);
+            if (link.prev != nullptr)
+            {
+                _tagLinks[link.prev].next = link.next;
+            }
+            else
+            {
+                auto it = _tagIndex.find(link.tag);
+                if (link.next != nullptr)
+                    it->second = link.next;
+                else
+                    _tagIndex.erase(it);
+            }
+            if (link.next != nullptr)
+                _tagLinks[link.next].prev = link.prev;
+        }
+
+        // 被淘汰的key的哈希值放入幽灵列表（满了就挤掉最早的）
+        void rememberGhost(size_t hash)
+        {
+            if (_ghostSize == _ghostCapacity)
+            {
+                // 这个位置上是最早的一个，先把它移出
+                auto it = _ghosts.find(_ghostRing[_ghostPos]);
+                if (--it->second == 0)
+                    _ghosts.erase(it);
+            }
+            else
+            {
+                _ghostSize++;
+            }
+            _ghostRing[_ghostPos] = hash;
+            _ghosts[hash]++;
+            _ghostPos = (_ghostPos + 1) % _ghostCapacity;
+        }
+
+        // 最久未使用的节点（跳过遍历游标）
+        NodePtr leastRecentNode()
+        {
+            NodePtr node = _dummyHead->_next;
+            if (node == _cursor)
+                node = node->_next;
+            return node;
+        }
+
+        // 快照模式下，修改/删除一个还没被遍历到的节点之前，保存它的原值（写时复制）
+        void preserveForSnapshot(const NodePtr &node)
+        {
+            if (_snapshot && node->_epoch < _walkEpoch)
+            {
+                _preserved.emplace_back(node->_key, node->_value);
+                node->_epoch = _walkEpoch; // 原值已经交给遍历者，遍历到它时跳过
+            }
+        }
+
+        // 缩容后元素个数超过容量（延迟淘汰时是容量+softOvershoot）时，每次操作顺带淘汰一小步（最多_evictStep个）
+        void trimToCapacity()
+        {
+            size_t limit = _capacity > 0 ? _capacity + _softOvershoot : 0;
+            for (int i = 0; i < _evictStep && _nodeMap.size() > limit; i++)
+            {
+                evictLeastRecent();
+            }
         }
     };
     // （3）KLruKCache类
@@ -209,6 +914,8 @@ namespace PerCache
         int _k;                                             // 访问次数
         unique_ptr<KLruCache<Key, size_t>> _historyCounter; // 指针。指向一个LRU缓存对象（由双向链表和哈希表构成）：一个计数器缓存，保存所有的Key -> 访问次数(注意如果key已经放在主缓存中，计数器不再计算key的访问次数)
         unordered_map<Key, Value> _historyValueMap;         // 哈希表。保存那些访问次数 < k_ 的 Key 对应的真实 Value（如果访问达k次，需要在哈希表中删除这对key-value）
+        unique_ptr<KBloomFilter<Key>> _doorkeeper;          // 可选的"门卫"布隆过滤器：第一次出现的key只记录在这里，不占用历史缓存
+        unique_ptr<KBloomFilter<Key>> _absentKeys;          // 可选的负缓存布隆过滤器：记录后端存储中确认不存在的key
         /*
             主缓存是KLruCache(因为KLruKCache构造时候，先构造出基类。即KLruKCache 本身有一个 KLruCache<Key, Value>缓存)，通过基类的get()/put()存取数据
             历史缓存是哈希表（因为value要么存在于主缓存，要么存在于哈希表中），但是哈希表需要配合KLruCache实例_historyCache一起使用。
@@ -225,18 +932,74 @@ namespace PerCache
         historyList 是一个 unique_ptr。它指向一个动态分配的 KLruCache<Key, Value> 对象。创建的时候把 historyCapacity 传给 KLruCache 的构造函数。
         */
 
+        // 开启"门卫"过滤器
+        /*
+            大量的miss是只出现一次的key（例如扫描、后端根本不存在的key），它们每次都会进入_historyCounter和_historyValueMap，
+            把真正有用的历史记录挤出去。开启门卫后，一个key第一次出现时只记录在布隆过滤器中，第二次出现才开始计入历史。
+            expectedKeys是过滤器每一代的key个数（轮换间隔），决定了"第一次出现"的记忆能保持多久。
+        */
+        void enableDoorkeeper(size_t expectedKeys, double falsePositiveRate = 0.01)
+        {
+            _doorkeeper.reset(new KBloomFilter<Key>(expectedKeys, falsePositiveRate));
+        }
+
+        // 开启负缓存：调用者在后端存储中查不到某个key时调用markAbsent记录下来
+        void enableNegativeCache(size_t expectedKeys, double falsePositiveRate = 0.01)
+        {
+            _absentKeys.reset(new KBloomFilter<Key>(expectedKeys, falsePositiveRate));
+        }
+
+        // 记录一个后端存储中不存在的key
+        void markAbsent(Key key)
+        {
+            if (_absentKeys)
+                _absentKeys->add(key);
+        }
+
+        // key是否（很可能）已知在后端存储中不存在，可以跳过回源
+        /*
+            布隆过滤器不能删除元素：一个key被markAbsent之后又被写入后端存储，在过滤器轮换掉它之前仍然会被判为不存在。
+            轮换间隔（expectedKeys）就是这种过期记录的最长寿命，需要比它更及时的话可以调用rotateNegativeCache()。
+        */
+        bool isKnownAbsent(Key key) const
+        {
+            return _absentKeys && _absentKeys->contains(key);
+        }
+
+        void rotateNegativeCache()
+        {
+            if (_absentKeys)
+                _absentKeys->rotate();
+        }
+
         // 查找哈希表_historyValueMap的key，返回对应的value
         Value get(Key key)
         {
-            // 首先尝试从主缓存LruCache中获取数据
             Value value{};
+            get(key, value);
+            return value;
+        }
+
+        // 和get(key)相同的LRU-K逻辑，通过输出参数返回value，返回是否命中
+        /*
+            如果不重写这个版本，通过KICachePolicy接口（例如KShardedCache）调用get(key, value)时
+            会直接调用到基类KLruCache的get，只查主缓存，历史计数永远不会增加，元素永远进不了主缓存。
+        */
+        bool get(Key key, Value &value) override
+        {
+            // 首先尝试从主缓存LruCache中获取数据
             bool inMainCache = KLruCache<Key, Value>::get(key, value);
             // 如果在主缓存中
             if (inMainCache)
             {
-                return value;
+                return true;
             }
             // 运行到这里说明数据不在主缓存
+            // 已知不存在的key、第一次出现的key，都不计入历史
+            if (isKnownAbsent(key) || !passDoorkeeper(key))
+            {
+                return false;
+            }
             // 获取并更新历史访问计数（put根据LRU算法放入历史缓存_historyCache）
             size_t historyCount = _historyCounter->get(key); // 注意KLruCache的get方法实现中，如果key不存在，返回0
             historyCount++;
@@ -259,15 +1022,16 @@ namespace PerCache
                     // 添加到主缓存
                     KLruCache<Key, Value>::put(key, storedValue);
                     // 找到数据 → 返回主缓存或历史缓存中的真实值value
-                    return storedValue;
+                    value = storedValue;
+                    return true;
                 }
             }
-            // 运行到这里，说明主缓存或历史缓存中都找不到数据 → 返回 Value{} 默认值
+            // 运行到这里，说明主缓存或历史缓存中都找不到数据
             /*
-                这里实际上有歧义。如果Value是int类型，默认值是0
-                那么，无法区分缓存命中时可能返回值就是0 or 缓存未命中时默认值0
+                get(key)版本在这里返回Value{}默认值，实际上有歧义。如果Value是int类型，默认值是0
+                那么，无法区分缓存命中时可能返回值就是0 or 缓存未命中时默认值0；这个版本用返回值区分
             */
-            return value;
+            return false;
         }
         // 添加缓存(到主缓存或者历史缓存)
         void put(Key key, Value value)
@@ -286,6 +1050,11 @@ namespace PerCache
                 return;
             }
             // 运行到这里，说明不存在主缓存中
+            // 第一次出现的key只记录在门卫过滤器中
+            if (!passDoorkeeper(key))
+            {
+                return;
+            }
             // 保存值到历史缓存哈希表中，供后续get操作使用
             _historyValueMap[key] = value;
             // 获取并更新历史访问计数（put根据LRU算法放入历史缓存_historyCache）
@@ -300,46 +1069,212 @@ namespace PerCache
                 KLruCache<Key, Value>::put(key, value);
             }
         }
+
+    private:
+        // 没有开启门卫时总是通过；开启后，第一次出现的key被拦下（并记录），之后再出现才通过
+        bool passDoorkeeper(const Key &key)
+        {
+            return !_doorkeeper || _doorkeeper->containsOrAdd(key);
+        }
     };
     // （4）KLruKCaches类
-    template <typename Key, typename Value>
+    // Hasher：key的哈希函数。每次操作只算一次哈希值，既用来选择分片，也传给分片内的哈希表（见KLruCache::getHashed）
+    template <typename Key, typename Value, typename Hasher = hash<Key>>
     class KHashLruCaches // 注意KLruKCaches未继承任何类
     {
     private:
-        size_t _capacity;                                          // 缓存总容量
-        int _sliceNum;                                             // 分片数量
-        vector<unique_ptr<KLruCache<Key, Value>>> _lruSliceCaches; // 分片缓存(是一个向量，元素是unique_ptr指针，每个指针指向一个KLruCache类型的缓存)
+        using SliceCache = KLruCache<Key, Value, Hasher>;
+
+        // 一种分片布局：分片数量 + 分片缓存
+        struct SliceLayout
+        {
+            int sliceNum;                                         // 分片数量
+            vector<unique_ptr<KCountingResource>> resources;      // 开启内存预算时每个分片的内存统计（在sliceCaches之前声明，析构时比分片晚）
+            vector<unique_ptr<SliceCache>> sliceCaches;           // 分片缓存(是一个向量，元素是unique_ptr指针，每个指针指向一个KLruCache类型的缓存)
+        };
+
+        size_t _capacity;                       // 缓存总容量
+        unique_ptr<KMemoryBudget> _budget;      // 内存预算（可选），在_layouts之前声明：分片析构时还要从预算中减去释放的内存
+        atomic<SliceLayout *> _layout;          // 当前分片布局
+        atomic<SliceLayout *> _oldLayout;       // 重新分片期间正在迁出的旧布局（没有迁移时为nullptr）
+        vector<unique_ptr<SliceLayout>> _layouts; // 创建过的所有布局（负责释放内存）
+        /*
+            为什么旧布局迁移完以后不马上释放？
+            get/put没有加任何全局锁，只是原子地读取一下_layout/_oldLayout指针，某个线程可能刚读到旧布局的指针还没来得及用。
+            迁移完的旧布局里的分片都已经是空的，只占很少的内存，留到析构时统一释放最简单也最安全。
+        */
+        // 热点key统计（可选，默认关闭）：每个分片一个sketch
+        struct HotKeyTracker
+        {
+            uint32_t sampleMask;                               // 采样率-1（采样率是2的幂）
+            vector<unique_ptr<KHotKeySketch<Key>>> sketches; // 按启用时的分片方式，每个分片一个
+        };
+        atomic<HotKeyTracker *> _hotKeys{nullptr};
+
+        int _softOvershoot = -1; // 延迟淘汰的参数（-1表示没有开启），重新分片创建的新分片也要开启
+        bool _backgroundReclaim = false;
+        unique_ptr<HotKeyTracker> _hotKeysOwner;
+
+        mutex _reshardMutex;           // 保证同一时间只有一个reshard在进行
+        thread _migrator;              // 后台迁移线程
+        mutex _migrateMutex;           // 迁移每搬运一批持有一次（请求不需要它，只用来和invalidateTag互斥）
+        atomic<bool> _stopMigration{false};
+
+        static const size_t _migrateStep = 64; // 迁移时每次持有旧分片锁最多搬运的元素个数
+        Hasher _hasher;
+
+        // 分片之间的容量调配（默认关闭，见enableRebalancing）
+        bool _rebalancing = false;        // 是否开启（开启后新布局的分片也有幽灵列表）
+        thread _rebalancer;               // 定期调配的后台线程
+        mutex _rebalanceMutex;            // 配合_rebalanceCv，让后台线程可以被及时叫醒退出
+        condition_variable _rebalanceCv;
+        bool _stopRebalance = false;
+
+        // 内存预算（可选，见memoryLimitBytes构造函数）
+        mutex _budgetMutex;                     // 同一时间只有一个线程按预算淘汰
+        static const size_t _budgetEvictStep = 8; // 每次从占用最多的分片淘汰的元素个数
     public:
         // KHashLruCaches类的构造函数
         KHashLruCaches(size_t capacity, int sliceNum)
-            : _capacity(capacity), _sliceNum(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()) // 如果slicenum<0使用CPU核心数
+            : _capacity(capacity), _oldLayout(nullptr)
+        {
+            // 如果slicenum<0使用CPU核心数
+            /*
+                注意不可以写成hardware_concurrency()（尽管using namespace std 以及#include<thread>。这里需要显式写出来std::thread::
+            */
+            _layout = createLayout(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency());
+        }
+
+        // 带内存预算的构造函数：所有分片实际占用的内存合计不超过memoryLimitBytes
         /*
-            注意不可以写成hardware_concurrency()（尽管using namespace std 以及#include<thread>。这里需要显式写出来std::thread::
+            容量按元素个数计算，不包括节点、哈希表的桶、shared_ptr控制块和value自己在堆上的内存。
+            这里每个分片有一个KCountingResource（见KMemoryBudget.h），这些内存都从它分配，合计到一个共享的KMemoryBudget上；
+            每次put之后如果总量超出预算，就从当前占用最多的分片按LRU顺序淘汰，直到回到预算以内才返回。
+            所以超出预算的只有正在进行中的put刚刚写入的那一点，put返回后总量不超过预算。
+            value是pmr::string、pmr::vector这种类型时，它在堆上的内存也计入预算；std::string的堆内存不在统计范围内。
+            注意每个分片的索引按容量预先分配了桶（见KLruCache的构造函数），这部分也计入预算，所以容量不要设得比实际需要大太多。
         */
+        KHashLruCaches(size_t capacity, int sliceNum, size_t memoryLimitBytes)
+            : _capacity(capacity), _budget(new KMemoryBudget(memoryLimitBytes)), _oldLayout(nullptr)
+        {
+            _layout = createLayout(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency());
+        }
+
+        ~KHashLruCaches()
         {
-            // 获取每个分片的大小 总大小/分片数 -> 向上取整
-            size_t sliceSize = ceil(_capacity / static_cast<double>(_sliceNum)); // static_cast将int类型转换为double类型：因为整数/整数会舍弃小数部分
-            // 创建sliceSize个分片（每个分片的类型都是KLruCache)
-            for (int i = 0; i < sliceSize; i++)
             {
-                _lruSliceCaches.emplace_back(new KLruCache<Key, Value>(sliceSize));
-                /*
-                如果不使用new,换一种写法：lruSliceCaches_.emplace_back(make_unique<KLruCache<Key, Value>>(sliceSize));
-                */
+                lock_guard<mutex> lock(_rebalanceMutex);
+                _stopRebalance = true;
             }
+            _rebalanceCv.notify_all();
+            if (_rebalancer.joinable())
+                _rebalancer.join();
+            _stopMigration = true;
+            if (_migrator.joinable())
+                _migrator.join();
         }
+
         // put——把key-value放入缓存中
         void put(Key key, Value value)
         {
-            size_t index = Hash(key) % _sliceNum; // 获取key的hash值，并计算出对应的分片索引
-            _lruSliceCaches[index]->put(key, value);
+            putTagged(key, value, nullptr);
+            enforceMemoryBudget();
+        }
+
+        // 带标签的put（见KLruCache::put(key, value, tag)）
+        void put(Key key, Value value, uint64_t tag)
+        {
+            putTagged(key, value, &tag);
+            enforceMemoryBudget();
+        }
+
+        // 所有分片当前实际占用的字节数（没有开启内存预算时返回0）
+        size_t memoryUsed() const
+        {
+            return _budget ? _budget->used() : 0;
+        }
+
+        size_t memoryLimit() const
+        {
+            return _budget ? _budget->limit() : 0;
+        }
+
+        // 运行时修改内存预算（调小时立即淘汰到预算以内）
+        void setMemoryLimit(size_t memoryLimitBytes)
+        {
+            if (!_budget)
+                return;
+            _budget->setLimit(memoryLimitBytes);
+            enforceMemoryBudget();
+        }
+
+        // 当前布局中每个分片实际占用的字节数（用来观察、报警）
+        vector<size_t> sliceMemoryUsed()
+        {
+            vector<size_t> used;
+            SliceLayout *layout = _layout.load();
+            for (auto &resource : layout->resources)
+                used.push_back(resource->bytes());
+            return used;
+        }
+
+        // 删除所有分片中带有tag标签的元素，返回删除的个数（batchSize见KLruCache::invalidateTag）
+        size_t invalidateTag(uint64_t tag, size_t batchSize = 0)
+        {
+            // 和迁移互斥：否则一个带标签的元素可能正好在"从旧分片取出、还没放进新分片"的途中，两边都删不到它
+            lock_guard<mutex> lock(_migrateMutex);
+            size_t removed = 0;
+            SliceLayout *layout = _layout.load();
+            for (auto &slice : layout->sliceCaches)
+                removed += slice->invalidateTag(tag, batchSize);
+            SliceLayout *oldLayout = _oldLayout.load();
+            if (oldLayout != nullptr && oldLayout != layout)
+            {
+                for (auto &slice : oldLayout->sliceCaches)
+                    removed += slice->invalidateTag(tag, batchSize);
+            }
+            return removed;
         }
 
+    private:
+        void putTagged(const Key &key, const Value &value, const uint64_t *tag)
+        {
+            size_t hashValue = Hash(key); // 只计算一次哈希值，分片选择、分片内查找和热点统计共用
+            sampleHotKey(key, hashValue);
+            SliceLayout *layout = _layout.load();
+            sliceOf(layout, hashValue)->putHashed(key, hashValue, value, tag);
+            /*
+                重新分片期间的写入：
+                如果写入时读到的还是旧布局，而新布局恰好在这期间发布了，这次写入可能落在一个已经迁移过的旧分片里，
+                之后再也不会被迁走（读请求先查新布局，可能读到迁移过去的旧值）。
+                所以写完以后再检查一次布局，变了就在新布局中重新写一遍，并删掉旧布局里的这份。
+            */
+            SliceLayout *current = _layout.load();
+            if (current != layout)
+            {
+                sliceOf(current, hashValue)->putHashed(key, hashValue, value, tag);
+                sliceOf(layout, hashValue)->removeHashed(key, hashValue);
+                return;
+            }
+            // 新布局中写入成功后，删除旧布局里的旧值，避免之后被迁移/读到
+            SliceLayout *oldLayout = _oldLayout.load();
+            if (oldLayout != nullptr)
+                sliceOf(oldLayout, hashValue)->removeHashed(key, hashValue);
+        }
+
+    public:
+
         // get——key是否存在
         bool get(Key key, Value &value)
         {
-            size_t index = Hash(key) % _sliceNum;
-            return _lruSliceCaches[index]->get(key, value);
+            size_t hashValue = Hash(key);
+            sampleHotKey(key, hashValue);
+            SliceLayout *layout = _layout.load();
+            if (sliceOf(layout, hashValue)->getHashed(key, hashValue, value))
+                return true;
+            // 重新分片期间，新布局中没有找到，再查一次旧布局（数据可能还没有迁移过来）
+            SliceLayout *oldLayout = _oldLayout.load();
+            return oldLayout != nullptr && oldLayout != layout && sliceOf(oldLayout, hashValue)->getHashed(key, hashValue, value);
         }
 
         // get——获取value
@@ -350,12 +1285,373 @@ namespace PerCache
             return value;
         }
 
+        // remove——删除key（重新分片期间新旧布局中都要删除）
+        void remove(Key key)
+        {
+            size_t hashValue = Hash(key);
+            SliceLayout *layout = _layout.load();
+            sliceOf(layout, hashValue)->removeHashed(key, hashValue);
+            SliceLayout *oldLayout = _oldLayout.load();
+            if (oldLayout != nullptr && oldLayout != layout)
+                sliceOf(oldLayout, hashValue)->removeHashed(key, hashValue);
+        }
+
+        // 运行时修改总容量：每个分片按新的分片容量增量淘汰（见KLruCache::setCapacity）
+        // 开启了容量调配时，各分片回到平均容量，重新开始调配
+        void setCapacity(size_t capacity)
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            _capacity = capacity;
+            SliceLayout *layout = _layout.load();
+            int sliceSize = sliceCapacity(layout->sliceNum);
+            for (auto &slice : layout->sliceCaches)
+            {
+                slice->setCapacity(sliceSize);
+                if (_rebalancing)
+                    slice->enableGhostList(ghostCapacity(layout->sliceNum));
+            }
+        }
+
+        // 运行时修改分片数量
+        /*
+            1.创建新布局并发布：之后的put都写入新布局，get先查新布局，再查旧布局
+            2.后台线程按分片逐个迁移旧布局：每次只锁住一个旧分片，最多搬运_migrateStep个元素，
+              搬到新布局时如果key已经存在（迁移期间又被写入了新值），保留新值
+            3.全部迁移完以后，撤销旧布局
+            请求在任何时刻最多只会等待一次迁移步骤（一个旧分片锁）。
+            如果上一次reshard的迁移还没有结束，这里会等它结束（只阻塞reshard的调用者，不阻塞请求）。
+        */
+        void reshard(int sliceNum)
+        {
+            if (sliceNum <= 0)
+                return;
+            lock_guard<mutex> lock(_reshardMutex);
+            if (_migrator.joinable())
+                _migrator.join();
+            SliceLayout *oldLayout = _layout.load();
+            if (oldLayout->sliceNum == sliceNum)
+                return;
+            SliceLayout *newLayout = createLayout(sliceNum);
+            _oldLayout.store(oldLayout); // 先发布旧布局，保证读到新布局的get一定也能查到旧布局
+            _layout.store(newLayout);
+            _migrator = thread([this, oldLayout, newLayout]()
+                               { migrate(oldLayout, newLayout); });
+        }
+
+        // 所有分片开启延迟淘汰（见KLruCache::enableDeferredEviction），softOvershoot是每个分片允许超出的个数
+        // 开启内存预算时不使用后台回收：被淘汰的节点要在淘汰它的put返回之前释放，预算的统计才是及时的
+        void enableDeferredEviction(int softOvershoot, bool backgroundReclaim = true)
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            _softOvershoot = softOvershoot > 0 ? softOvershoot : 0;
+            _backgroundReclaim = backgroundReclaim && !_budget;
+            for (auto &slice : _layout.load()->sliceCaches)
+                slice->enableDeferredEviction(_softOvershoot, _backgroundReclaim);
+        }
+
+        // 开启热点key统计
+        /*
+            keysPerShard：每个分片的sketch保留的计数器个数
+            sampleRate：每个线程每sampleRate次get/put采样一次（向上取整为2的幂，1表示每次都记录）
+            只能开启一次，之后再调用不会改变参数。
+        */
+        void enableHotKeyDetection(size_t keysPerShard = 64, uint32_t sampleRate = 64)
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            if (_hotKeysOwner)
+                return;
+            uint32_t rate = 1;
+            while (rate < sampleRate)
+                rate <<= 1;
+            unique_ptr<HotKeyTracker> tracker(new HotKeyTracker());
+            tracker->sampleMask = rate - 1;
+            for (int i = 0; i < _layout.load()->sliceNum; i++)
+                tracker->sketches.emplace_back(new KHotKeySketch<Key>(keysPerShard));
+            _hotKeys.store(tracker.get());
+            _hotKeysOwner = move(tracker);
+        }
+
+        // 合并所有分片的统计，返回估计访问次数最多的n个key（没有开启统计时返回空）
+        vector<KHotKey<Key>> topKeys(size_t n)
+        {
+            HotKeyTracker *tracker = _hotKeys.load();
+            if (tracker == nullptr)
+                return vector<KHotKey<Key>>();
+            vector<KHotKey<Key>> all;
+            for (auto &sketch : tracker->sketches)
+                sketch->collect(all);
+            return KHotKeySketch<Key>::merge(all, n, tracker->sampleMask + 1);
+        }
+
+        // 开启分片之间的自适应容量调配
+        /*
+            所有分片一样大时，key分布倾斜的情况下热的分片不停地淘汰，冷的分片却空着一半，总命中率远低于一个同样大的全局LRU。
+            开启后每个分片维护一个小的幽灵列表（见KLruCache::enableGhostList），记录"多给这个分片一点容量能多得到的命中数"，
+            后台线程每隔interval调用一次rebalance：把容量从边际收益低的分片挪给边际收益高的分片，总容量不变。
+            最终各分片的边际收益趋于相等，命中率接近全局LRU，而请求仍然只锁一个分片。
+            interval为0时不启动后台线程，由调用者自己定期调用rebalance。
+        */
+        void enableRebalancing(chrono::milliseconds interval = chrono::milliseconds(100))
+        {
+            {
+                lock_guard<mutex> lock(_reshardMutex);
+                if (_rebalancing)
+                    return;
+                _rebalancing = true;
+                SliceLayout *layout = _layout.load();
+                for (auto &slice : layout->sliceCaches)
+                    slice->enableGhostList(ghostCapacity(layout->sliceNum));
+            }
+            if (interval.count() > 0)
+            {
+                _rebalancer = thread([this, interval]()
+                                     {
+                                         unique_lock<mutex> lock(_rebalanceMutex);
+                                         while (!_rebalanceCv.wait_for(lock, interval, [this]() { return _stopRebalance; }))
+                                         {
+                                             lock.unlock();
+                                             rebalance();
+                                             lock.lock();
+                                         } });
+            }
+        }
+
+        // 调配一次容量：按上一周期的幽灵命中数排序，收益最高的和最低的配对、次高的和次低的配对……
+        // 每对从低收益分片挪rebalanceStep个容量给高收益分片（低收益分片最少保留平均容量的1/8，到了最小值就换下一个分片来捐出）
+        void rebalance()
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            if (!_rebalancing || _oldLayout.load() != nullptr) // 重新分片期间不调配
+                return;
+            SliceLayout *layout = _layout.load();
+            int sliceNum = layout->sliceNum;
+            vector<pair<uint64_t, int>> gains; // 幽灵命中数，分片下标
+            for (int i = 0; i < sliceNum; i++)
+                gains.emplace_back(layout->sliceCaches[i]->takeGhostHits(), i);
+            sort(gains.begin(), gains.end());
+            int step = rebalanceStep(sliceNum);
+            int minCapacity = max(1, sliceCapacity(sliceNum) / 8);
+            int low = 0, high = sliceNum - 1;
+            while (low < high && gains[high].first > gains[low].first) // 收益相同的分片之间不挪动
+            {
+                SliceCache *from = layout->sliceCaches[gains[low].second].get();
+                SliceCache *to = layout->sliceCaches[gains[high].second].get();
+                int moved = min(step, from->getCapacity() - minCapacity);
+                if (moved > 0)
+                {
+                    from->setCapacity(from->getCapacity() - moved); // 缩容是增量的，不会长时间持有分片锁
+                    to->setCapacity(to->getCapacity() + moved);
+                    high--;
+                }
+                low++; // 已经缩到最小的分片不再捐出，换下一个收益低的分片
+            }
+        }
+
+        // 每个分片当前的容量（调配以后各不相同，总和不变）
+        vector<int> sliceCapacities()
+        {
+            vector<int> capacities;
+            for (auto &slice : _layout.load()->sliceCaches)
+                capacities.push_back(slice->getCapacity());
+            return capacities;
+        }
+
+        // 等待后台迁移结束
+        void waitForReshard()
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            if (_migrator.joinable())
+                _migrator.join();
+        }
+
+        // 当前分片数量
+        int sliceNum() const
+        {
+            return _layout.load()->sliceNum;
+        }
+
+        // 分批遍历所有分片的元素（见KLruCache::forEach），一次只锁一个分片的一小批
+        /*
+            如果正在重新分片，先等待迁移结束（只阻塞遍历者），遍历期间不会开始新的reshard，
+            这样元素不会在分片之间移动，也就不会被遍历两次或者漏掉。
+            快照模式下先在所有分片上开始快照再逐个分片遍历，每个分片都是各自开始时刻的快照
+            （各分片开始的时刻只相差几次加锁，但不是严格的同一时刻）。
+        */
+        template <typename Fn>
+        void forEach(Fn fn, size_t chunkSize = 64, bool snapshot = false)
+        {
+            lock_guard<mutex> lock(_reshardMutex);
+            if (_migrator.joinable())
+                _migrator.join();
+            SliceLayout *layout = _layout.load();
+            // fn抛出异常时，guards析构，还没结束的分片都会结束遍历
+            vector<unique_ptr<typename SliceCache::WalkGuard>> guards;
+            for (auto &slice : layout->sliceCaches)
+                guards.push_back(make_unique<typename SliceCache::WalkGuard>(*slice, snapshot));
+            vector<pair<Key, Value>> chunk;
+            for (size_t i = 0; i < layout->sliceCaches.size(); i++)
+            {
+                bool more = true;
+                while (more)
+                {
+                    chunk.clear();
+                    more = layout->sliceCaches[i]->walkStep(chunkSize, chunk);
+                    for (auto &entry : chunk)
+                        fn(entry.first, entry.second);
+                }
+                guards[i]->finish();
+            }
+        }
+
+        // 时间点快照：导出所有分片的内容
+        vector<pair<Key, Value>> snapshot(size_t chunkSize = 64)
+        {
+            vector<pair<Key, Value>> out;
+            forEach([&out](const Key &key, const Value &value)
+                    { out.emplace_back(key, value); },
+                    chunkSize, true);
+            return out;
+        }
+
+        // 当前元素个数（重新分片期间包含旧布局中还没迁移的元素）
+        size_t size()
+        {
+            size_t total = 0;
+            SliceLayout *layout = _layout.load();
+            for (auto &slice : layout->sliceCaches)
+                total += slice->size();
+            SliceLayout *oldLayout = _oldLayout.load();
+            if (oldLayout != nullptr && oldLayout != layout)
+            {
+                for (auto &slice : oldLayout->sliceCaches)
+                    total += slice->size();
+            }
+            return total;
+        }
+
     private:
+        // 获取每个分片的大小 总大小/分片数 -> 向上取整
+        int sliceCapacity(int sliceNum) const
+        {
+            return ceil(_capacity / static_cast<double>(sliceNum)); // static_cast将int类型转换为double类型：因为整数/整数会舍弃小数部分
+        }
+
+        // 每次调配挪动的容量：平均容量的1/16
+        int rebalanceStep(int sliceNum) const
+        {
+            return max(1, sliceCapacity(sliceNum) / 16);
+        }
+
+        // 幽灵列表的大小：两步的调配量
+        size_t ghostCapacity(int sliceNum) const
+        {
+            return 2 * rebalanceStep(sliceNum);
+        }
+
+        // 创建一个新布局（由_layouts负责释放）
+        SliceLayout *createLayout(int sliceNum)
+        {
+            unique_ptr<SliceLayout> layout(new SliceLayout());
+            layout->sliceNum = sliceNum;
+            int sliceSize = sliceCapacity(sliceNum);
+            // 创建sliceNum个分片（每个分片的类型都是KLruCache)
+            for (int i = 0; i < sliceNum; i++)
+            {
+                if (_budget)
+                {
+                    layout->resources.emplace_back(new KCountingResource(_budget.get()));
+                    layout->sliceCaches.emplace_back(new SliceCache(sliceSize, layout->resources.back().get()));
+                }
+                else
+                {
+                    layout->sliceCaches.emplace_back(new SliceCache(sliceSize));
+                }
+                /*
+                如果不使用new,换一种写法：lruSliceCaches_.emplace_back(make_unique<KLruCache<Key, Value>>(sliceSize));
+                */
+                if (_softOvershoot >= 0)
+                    layout->sliceCaches.back()->enableDeferredEviction(_softOvershoot, _backgroundReclaim);
+                if (_rebalancing)
+                    layout->sliceCaches.back()->enableGhostList(ghostCapacity(sliceNum)); // 新布局从平均容量重新开始调配
+            }
+            _layouts.push_back(move(layout));
+            return _layouts.back().get();
+        }
+
+        // key所在的分片（hashValue是key的哈希值）
+        SliceCache *sliceOf(SliceLayout *layout, size_t hashValue)
+        {
+            size_t index = hashValue % layout->sliceNum; // 根据key的hash值计算出对应的分片索引
+            return layout->sliceCaches[index].get();
+        }
+
+        // 热点key采样：没有开启时只有一次原子读；开启后每个线程每sampleRate次操作记录一次
+        void sampleHotKey(const Key &key, size_t hashValue)
+        {
+            HotKeyTracker *tracker = _hotKeys.load(memory_order_acquire);
+            if (tracker == nullptr)
+                return;
+            static thread_local uint32_t tick = 0; // 每个线程自己计数，不需要原子操作
+            if ((++tick & tracker->sampleMask) != 0)
+                return;
+            tracker->sketches[hashValue % tracker->sketches.size()]->offer(key);
+        }
+
+        // 后台迁移：逐个旧分片，每次搬运一小批
+        void migrate(SliceLayout *oldLayout, SliceLayout *newLayout)
+        {
+            vector<typename SliceCache::Entry> batch;
+            for (auto &slice : oldLayout->sliceCaches)
+            {
+                while (!_stopMigration)
+                {
+                    batch.clear();
+                    lock_guard<mutex> lock(_migrateMutex);
+                    // 从最久未使用的一端取，搬到新分片后仍然保持原来的新旧顺序；哈希值和标签一起搬过去
+                    if (slice->extractLeastRecent(_migrateStep, batch) == 0)
+                        break;
+                    for (auto &entry : batch)
+                        sliceOf(newLayout, entry.hash)->putIfAbsentHashed(entry.key, entry.hash, entry.value, entry.tagged ? &entry.tag : nullptr);
+                }
+                slice->releaseIndexIfEmpty(); // 旧布局留到析构时才释放，先把迁空的分片的桶数组还回去
+            }
+            if (!_stopMigration)
+                _oldLayout.store(nullptr);
+        }
+
+        // 超出内存预算时，每次从占用最多的（非空）分片淘汰一小批，直到回到预算以内
+        void enforceMemoryBudget()
+        {
+            if (!_budget || !_budget->overLimit())
+                return;
+            lock_guard<mutex> lock(_budgetMutex); // 其它超出预算的写入者等在这里，轮到它时再检查一次，不会重复淘汰
+            while (_budget->overLimit())
+            {
+                SliceCache *largest = nullptr;
+                size_t largestBytes = 0;
+                for (SliceLayout *layout : {_oldLayout.load(), _layout.load()}) // 重新分片期间旧布局中的元素也占内存
+                {
+                    if (layout == nullptr)
+                        continue;
+                    for (int i = 0; i < layout->sliceNum; i++)
+                    {
+                        size_t bytes = layout->resources[i]->bytes();
+                        if (bytes > largestBytes && layout->sliceCaches[i]->size() > 0)
+                        {
+                            largest = layout->sliceCaches[i].get();
+                            largestBytes = bytes;
+                        }
+                    }
+                }
+                if (largest == nullptr || largest->evict(_budgetEvictStep) == 0)
+                    break; // 已经没有可以淘汰的元素（剩下的是桶数组等固定开销）
+            }
+        }
+
         // 将key转化为对应的哈希值
-        size_t Hash(Key key)
+        size_t Hash(const Key &key) const
         {
-            hash<Key> hashFunc;
-            return hashFunc(key);
+            return _hasher(key);
         }
     };
 }
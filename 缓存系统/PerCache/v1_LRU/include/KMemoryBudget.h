@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource> //pmr::memory_resource
+using namespace std;
+
+namespace PerCache
+{
+    // KMemoryBudget类：多个分片共享的内存预算（字节）
+    /*
+        只负责记账：所有KCountingResource分配、释放的字节数都加到_used上。
+        超出预算以后由缓存自己淘汰（见KHashLruCaches的memoryLimitBytes构造函数），这里不会拒绝分配。
+    */
+    class KMemoryBudget
+    {
+    private:
+        atomic<size_t> _used{0};
+        atomic<size_t> _limit;
+
+    public:
+        explicit KMemoryBudget(size_t limitBytes) : _limit(limitBytes) {}
+
+        size_t used() const { return _used.load(memory_order_relaxed); }
+        size_t limit() const { return _limit.load(memory_order_relaxed); }
+        void setLimit(size_t limitBytes) { _limit.store(limitBytes, memory_order_relaxed); }
+        bool overLimit() const { return used() > limit(); }
+
+        void add(size_t bytes) { _used.fetch_add(bytes, memory_order_relaxed); }
+        void sub(size_t bytes) { _used.fetch_sub(bytes, memory_order_relaxed); }
+    };
+
+    // KCountingResource类：统计实际分配字节数的内存资源（std::pmr）
+    /*
+        把分配转发给上游资源（默认是new/delete），同时记录自己当前持有的字节数，并计入共享的KMemoryBudget（可以为空）。
+        KLruCache把它用于：节点和shared_ptr控制块（allocate_shared）、索引的节点和桶数组、
+        以及key/value自己在堆上的内存（前提是key/value是pmr::string、pmr::vector这种使用polymorphic_allocator的类型）。
+        统计的是向上游申请的字节数，不包括malloc自己的头部和对齐浪费。
+    */
+    class KCountingResource : public pmr::memory_resource
+    {
+    private:
+        pmr::memory_resource *_upstream;
+        KMemoryBudget *_budget;
+        atomic<size_t> _bytes{0};
+
+    public:
+        explicit KCountingResource(KMemoryBudget *budget = nullptr,
+                                   pmr::memory_resource *upstream = pmr::new_delete_resource())
+            : _upstream(upstream), _budget(budget)
+        {
+        }
+
+        // 当前持有的字节数
+        size_t bytes() const { return _bytes.load(memory_order_relaxed); }
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            void *p = _upstream->allocate(bytes, alignment);
+            _bytes.fetch_add(bytes, memory_order_relaxed);
+            if (_budget != nullptr)
+                _budget->add(bytes);
+            return p;
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            _upstream->deallocate(p, bytes, alignment);
+            _bytes.fetch_sub(bytes, memory_order_relaxed);
+            if (_budget != nullptr)
+                _budget->sub(bytes);
+        }
+
+        bool do_is_equal(const pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
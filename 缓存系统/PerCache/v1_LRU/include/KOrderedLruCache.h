@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <functional> //less
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "KICachePolicy.h"
+using namespace std;
+
+namespace PerCache
+{
+    // KOrderedLruCache类：按key有序的LRU缓存，支持范围查询和前缀查询
+    /*
+        KLruCache的索引是unordered_map，只能按key精确查找，回答不了"用户X在t1到t2之间的所有缓存项"这样的查询。
+        这里的索引是按Compare排序的map（红黑树），LRU双向链表的前驱、后继指针直接放在map的节点里：
+        有序索引和LRU链表是同一批节点，插入、删除、淘汰时两者天然同步，每个元素只分配一次内存。
+            get/put/remove：O(log n)
+            rangeGet(lo, hi)：O(log n + 结果个数)，返回lo <= key <= hi的元素（按key从小到大）
+            prefixGet(prefix)：O(log n + 结果个数)，返回以prefix开头的元素（key需要是string这样有compare/size的类型）
+        范围查询默认不改变被扫描元素的新旧（扫一遍大范围不会把真正的热点挤出缓存），touch = true时把返回的元素都移到最新位置。
+        limit限制一次最多返回的个数，结果很多时分几次查询（下一次从上一次最后一个key之后开始），避免长时间持有锁。
+        和KLruCache一样用一把互斥锁保护，所以这里没有用并发跳表：所有访问本来就是串行的。
+    */
+    template <typename Key, typename Value, typename Compare = less<Key>>
+    class KOrderedLruCache : public KICachePolicy<Key, Value>
+    {
+    private:
+        struct Node
+        {
+            Value value{};
+            Node *prev = nullptr; // 更旧的元素
+            Node *next = nullptr; // 更新的元素
+            const Key *key = nullptr; // 指向map节点中的key
+        };
+
+        using Index = map<Key, Node, Compare>;
+
+        int _capacity;
+        Index _index;
+        Node _head; // 哨兵：_head.next是最久未访问的元素
+        Node _tail; // 哨兵：_tail.prev是最近访问的元素
+        mutex _mutex;
+
+    public:
+        explicit KOrderedLruCache(int capacity)
+            : _capacity(capacity)
+        {
+            _head.next = &_tail;
+            _tail.prev = &_head;
+        }
+
+        KOrderedLruCache(const KOrderedLruCache &) = delete;
+        KOrderedLruCache &operator=(const KOrderedLruCache &) = delete;
+
+        void put(Key key, Value value) override
+        {
+            if (_capacity <= 0)
+                return;
+            lock_guard<mutex> lock(_mutex);
+            auto it = _index.lower_bound(key);
+            if (it != _index.end() && !_index.key_comp()(key, it->first))
+            {
+                it->second.value = value;
+                moveToMostRecent(&it->second);
+                return;
+            }
+            if (_index.size() >= static_cast<size_t>(_capacity))
+            {
+                // 被淘汰的可能正是it指向的元素（新key的后继），淘汰之后重新查找插入位置
+                evictLeastRecent();
+                it = _index.lower_bound(key);
+            }
+            it = _index.emplace_hint(it, key, Node());
+            Node *node = &it->second;
+            node->value = value;
+            node->key = &it->first;
+            insertNode(node);
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it == _index.end())
+                return false;
+            moveToMostRecent(&it->second);
+            value = it->second.value;
+            return true;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        bool remove(Key key)
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it == _index.end())
+                return false;
+            removeNode(&it->second);
+            _index.erase(it);
+            return true;
+        }
+
+        // 范围查询：把lo <= key <= hi的元素按key从小到大追加到out，返回追加的个数
+        size_t rangeGet(const Key &lo, const Key &hi, vector<pair<Key, Value>> &out,
+                        bool touch = false, size_t limit = SIZE_MAX)
+        {
+            lock_guard<mutex> lock(_mutex);
+            size_t count = 0;
+            for (auto it = _index.lower_bound(lo); it != _index.end() && count < limit; ++it)
+            {
+                if (_index.key_comp()(hi, it->first))
+                    break;
+                collect(it, out, touch);
+                count++;
+            }
+            return count;
+        }
+
+        // 前缀查询：把以prefix开头的元素按key从小到大追加到out，返回追加的个数
+        size_t prefixGet(const Key &prefix, vector<pair<Key, Value>> &out,
+                         bool touch = false, size_t limit = SIZE_MAX)
+        {
+            lock_guard<mutex> lock(_mutex);
+            size_t count = 0;
+            // 以prefix开头的key在有序索引中是连续的一段，从第一个不小于prefix的key开始
+            for (auto it = _index.lower_bound(prefix); it != _index.end() && count < limit; ++it)
+            {
+                if (it->first.size() < prefix.size() || it->first.compare(0, prefix.size(), prefix) != 0)
+                    break;
+                collect(it, out, touch);
+                count++;
+            }
+            return count;
+        }
+
+        size_t size()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _index.size();
+        }
+
+    private:
+        void collect(typename Index::iterator it, vector<pair<Key, Value>> &out, bool touch)
+        {
+            out.emplace_back(it->first, it->second.value);
+            if (touch)
+                moveToMostRecent(&it->second); // 按扫描顺序移动，key最大的成为最近访问的
+        }
+
+        void insertNode(Node *node)
+        {
+            node->prev = _tail.prev;
+            node->next = &_tail;
+            _tail.prev->next = node;
+            _tail.prev = node;
+        }
+
+        void removeNode(Node *node)
+        {
+            node->prev->next = node->next;
+            node->next->prev = node->prev;
+        }
+
+        void moveToMostRecent(Node *node)
+        {
+            removeNode(node);
+            insertNode(node);
+        }
+
+        void evictLeastRecent()
+        {
+            Node *victim = _head.next;
+            removeNode(victim);
+            _index.erase(_index.find(*victim->key)); // 先find再erase，不会用到已经析构的key
+        }
+    };
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+using namespace std;
+
+namespace PerCache
+{
+    // 一次测量的结果
+    struct KPerfSample
+    {
+        struct Counter
+        {
+            string name;
+            bool available; // 这个计数器在当前环境下能否使用
+            double value;
+        };
+        vector<Counter> counters; // 硬件计数器（不可用时available为false）
+        double wallSeconds = 0;   // 墙上时间
+        double cpuSeconds = 0;    // 本进程所有线程的CPU时间（用户态+内核态）
+        long contextSwitches = 0; // 上下文切换次数（getrusage统计，总是可用；report中和硬件计数器一样按每次操作输出）
+
+        // 按每次操作输出：ops是这一阶段的操作次数
+        void report(ostream &out, const string &phase, uint64_t ops) const
+        {
+            double perOp = ops > 0 ? 1.0 / ops : 0;
+            out << phase << ": " << ops << " ops, " << ops / (wallSeconds > 0 ? wallSeconds : 1) << " ops/s, "
+                << wallSeconds * 1e9 * perOp << " ns/op wall, " << cpuSeconds * 1e9 * perOp << " ns/op cpu" << endl;
+            out << "    per op:";
+            for (auto &counter : counters)
+            {
+                out << " " << counter.name << " ";
+                if (counter.available)
+                    out << fixed << setprecision(2) << counter.value * perOp << defaultfloat << setprecision(6);
+                else
+                    out << "n/a";
+            }
+            out << " context-switches " << contextSwitches * perOp << endl; // 通常远小于1，用默认格式（科学计数法）输出
+        }
+    };
+
+    // KPerfCounters类：用perf_event_open给一段被测代码加上硬件计数器
+    /*
+        用法：
+            KPerfCounters perf;
+            perf.start();
+            ...被测代码...
+            KPerfSample sample = perf.stop();
+            sample.report(cout, "get", ops);
+        统计的是整个进程（inherit：start之后创建的线程也计入），只统计用户态（exclude_kernel），
+        这样在perf_event_paranoid = 2的机器上普通用户也能打开。
+        计数器个数超过硬件寄存器时内核会分时复用，这里按 启用时间/运行时间 做了缩放。
+        同一组计数器可以测量多个阶段：start时读一次（计数值、启用时间、运行时间），stop时再读一次，报告两次的差。
+        不用PERF_EVENT_IOC_RESET清零：它只清零父事件自己的计数，已经退出的继承线程累加进来的计数清不掉，
+        前一个阶段join掉的线程会被算进后面的每个阶段。
+        容器、虚拟机里经常没有硬件计数器（或者被seccomp禁止）：打不开的计数器标记为不可用，
+        仍然输出墙上时间、CPU时间和上下文切换次数（来自steady_clock/getrusage），不会让压测失败。
+    */
+    class KPerfCounters
+    {
+    private:
+        struct Event
+        {
+            const char *name;
+            uint32_t type;
+            uint64_t config;
+            int fd;
+            uint64_t startData[3]; // start时读到的计数值、启用时间、实际运行时间
+        };
+        vector<Event> _events;
+        bool _hardware = false; // 是否至少有一个计数器打开成功
+        chrono::steady_clock::time_point _startWall;
+        double _startCpu = 0;
+        long _startSwitches = 0;
+
+    public:
+        explicit KPerfCounters(bool useHardware = true)
+        {
+            const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            _events = {
+                {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1, {0, 0, 0}},
+                {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1, {0, 0, 0}},
+                {"L1d-misses", PERF_TYPE_HW_CACHE, l1dReadMiss, -1, {0, 0, 0}},
+                {"LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1, {0, 0, 0}},
+                {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1, {0, 0, 0}},
+            };
+            if (!useHardware)
+                return;
+            for (auto &event : _events)
+            {
+                event.fd = openEvent(event.type, event.config);
+                _hardware = _hardware || event.fd >= 0;
+            }
+        }
+
+        ~KPerfCounters()
+        {
+            for (auto &event : _events)
+            {
+                if (event.fd >= 0)
+                    close(event.fd);
+            }
+        }
+
+        KPerfCounters(const KPerfCounters &) = delete;
+        KPerfCounters &operator=(const KPerfCounters &) = delete;
+
+        // 是否有可用的硬件计数器（false时只有软件计时）
+        bool hardwareAvailable() const { return _hardware; }
+
+        void start()
+        {
+            for (auto &event : _events)
+            {
+                if (event.fd >= 0)
+                {
+                    ioctl(event.fd, PERF_EVENT_IOC_ENABLE, 0);
+                    if (read(event.fd, event.startData, sizeof(event.startData)) != sizeof(event.startData))
+                        event.startData[0] = event.startData[1] = event.startData[2] = 0;
+                }
+            }
+            _startCpu = cpuSeconds(_startSwitches);
+            _startWall = chrono::steady_clock::now();
+        }
+
+        KPerfSample stop()
+        {
+            KPerfSample sample;
+            sample.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - _startWall).count();
+            long switches = 0;
+            sample.cpuSeconds = cpuSeconds(switches) - _startCpu;
+            sample.contextSwitches = switches - _startSwitches;
+            for (auto &event : _events)
+            {
+                KPerfSample::Counter counter{event.name, false, 0};
+                if (event.fd >= 0)
+                {
+                    ioctl(event.fd, PERF_EVENT_IOC_DISABLE, 0);
+                    uint64_t data[3] = {0, 0, 0}; // 计数值、启用时间、实际运行时间（包括已退出的继承线程的）
+                    if (read(event.fd, data, sizeof(data)) == sizeof(data) && data[2] > event.startData[2])
+                    {
+                        double count = static_cast<double>(data[0] - event.startData[0]);
+                        double enabled = static_cast<double>(data[1] - event.startData[1]);
+                        double running = static_cast<double>(data[2] - event.startData[2]);
+                        counter.available = true;
+                        counter.value = count * enabled / running; // 这个阶段的计数，按分时复用缩放
+                    }
+                }
+                sample.counters.push_back(counter);
+            }
+            return sample;
+        }
+
+    private:
+        static int openEvent(uint32_t type, uint64_t config)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1;        // 之后创建的线程也计入
+            attr.exclude_kernel = 1; // 只统计用户态
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0); // 本进程，任意CPU
+            return static_cast<int>(fd);
+        }
+
+        // 本进程的CPU时间（秒），同时取出上下文切换次数（自愿+非自愿）
+        static double cpuSeconds(long &contextSwitches)
+        {
+            rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+            return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        }
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+namespace PerCache
+{
+    // KReclaimer类：后台回收线程
+    /*
+        缓存淘汰时，被淘汰的value可能持有很大的堆内存（例如几MB的string），析构它比淘汰本身慢得多。
+        淘汰者在锁内只把节点从链表和哈希表中摘下来，打包成一批交给回收线程，由回收线程在后台析构。
+        批次用shared_ptr<void>表示：最后一个引用在回收线程中释放，析构也就发生在回收线程中。
+    */
+    class KReclaimer
+    {
+    private:
+        mutex _mutex;
+        condition_variable _cond;
+        deque<shared_ptr<void>> _batches;
+        size_t _inFlight = 0; // 已经从_batches取出、正在析构的批次数
+        bool _stop = false;
+        thread _worker;
+
+    public:
+        KReclaimer()
+            : _worker([this]()
+                      { run(); })
+        {
+        }
+
+        // 析构时先回收完所有已提交的批次
+        ~KReclaimer()
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cond.notify_one();
+            _worker.join();
+        }
+
+        // 所有缓存共用的回收线程
+        static KReclaimer &shared()
+        {
+            static KReclaimer reclaimer;
+            return reclaimer;
+        }
+
+        // 提交一批待析构的对象
+        void post(shared_ptr<void> batch)
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _batches.push_back(move(batch));
+            }
+            _cond.notify_one();
+        }
+
+        // 等待已提交的批次全部回收完（主要用于测试）：队列为空，并且取出的批次也已经析构完
+        void drain()
+        {
+            unique_lock<mutex> lock(_mutex);
+            _cond.wait(lock, [this]()
+                       { return _batches.empty() && _inFlight == 0; });
+        }
+
+    private:
+        void run()
+        {
+            unique_lock<mutex> lock(_mutex);
+            while (true)
+            {
+                _cond.wait(lock, [this]()
+                           { return _stop || !_batches.empty(); });
+                if (_batches.empty())
+                    return; // _stop且已经回收完
+                shared_ptr<void> batch = move(_batches.front());
+                _batches.pop_front();
+                _inFlight++;
+                lock.unlock();
+                batch.reset(); // 在锁外析构
+                lock.lock();
+                _inFlight--;
+                if (_batches.empty() && _inFlight == 0)
+                    _cond.notify_all(); // 唤醒drain
+            }
+        }
+    };
+}
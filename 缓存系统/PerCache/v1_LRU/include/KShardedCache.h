@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional> //hash函数
+#include <memory>
+#include <thread>     //hardware_concurrency
+#include <vector>
+#include <math.h>     //ceil
+#include "KICachePolicy.h"
+#include "KCache.h" //加锁策略KMutexLock / KSpinLock / KNoLock
+using namespace std;
+
+namespace PerCache
+{
+    // 分片缓存的统计（所有分片相加）
+    struct KShardedStats
+    {
+        uint64_t gets = 0;
+        uint64_t hits = 0;
+        uint64_t puts = 0;
+        double hitRate() const { return gets > 0 ? static_cast<double>(hits) / gets : 0; }
+    };
+
+    // KShardedCache类：把任意KICachePolicy实现分成多个分片
+    /*
+        KHashLruCaches只能给KLruCache分片。这里的分片方式和它相同（key的哈希值对分片数取模），
+        但分片的类型是模板参数Policy，可以是KLruKCache、KSlruCache、KCacheAdapter（LFU）……
+        每个分片独立加锁，不同分片上的请求互不等待，任何策略都可以利用多核。
+            Policy  —— 分片的缓存类型，必须继承KICachePolicy<Key, Value>
+            Locking —— 每个分片外面加的锁（见KCache.h）：KLruKCache的历史表本身不是线程安全的，所以默认用KMutexLock；
+                       KLruCache这种自己已经加锁的策略可以用KNoLock，避免重复加锁
+            Hasher  —— 选择分片的哈希函数
+        构造函数：KShardedCache(总容量, 分片数, 其余构造参数...)，每个分片构造为Policy(ceil(总容量/分片数), 其余构造参数...)。
+        注意其余参数是原样传给每个分片的（例如KLruKCache的historyCapacity是每个分片的历史容量）。
+    */
+    template <typename Policy, typename Locking = KMutexLock,
+              typename Hasher = hash<typename Policy::KeyType>>
+    class KShardedCache : public KICachePolicy<typename Policy::KeyType, typename Policy::ValueType>
+    {
+    public:
+        using Key = typename Policy::KeyType;
+        using Value = typename Policy::ValueType;
+
+    private:
+        // 每个分片独占缓存行，相邻分片的锁和计数器不会互相干扰（伪共享）
+        struct alignas(64) Shard
+        {
+            unique_ptr<Policy> cache;
+            Locking lock;
+            atomic<uint64_t> gets{0};
+            atomic<uint64_t> hits{0};
+            atomic<uint64_t> puts{0};
+        };
+
+        size_t _capacity;
+        int _shardNum;
+        unique_ptr<Shard[]> _shards;
+        Hasher _hasher;
+
+    public:
+        template <typename... PolicyArgs>
+        KShardedCache(size_t capacity, int shardNum, PolicyArgs... policyArgs)
+            : _capacity(capacity),
+              _shardNum(shardNum > 0 ? shardNum : static_cast<int>(std::thread::hardware_concurrency())),
+              _shards(new Shard[_shardNum])
+        {
+            int shardCapacity = ceil(_capacity / static_cast<double>(_shardNum));
+            for (int i = 0; i < _shardNum; i++)
+                _shards[i].cache.reset(new Policy(shardCapacity, policyArgs...));
+        }
+
+        void put(Key key, Value value) override
+        {
+            Shard &shard = shardOf(key);
+            {
+                lock_guard<Locking> lock(shard.lock); // 策略抛出异常（比如bad_alloc）时也会解锁
+                shard.cache->put(key, value);
+            }
+            shard.puts.fetch_add(1, memory_order_relaxed);
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            Shard &shard = shardOf(key);
+            bool found;
+            {
+                lock_guard<Locking> lock(shard.lock);
+                found = shard.cache->get(key, value);
+            }
+            shard.gets.fetch_add(1, memory_order_relaxed);
+            if (found)
+                shard.hits.fetch_add(1, memory_order_relaxed);
+            return found;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        // 在key所在的分片上（持有分片锁）执行fn(Policy&)，用来调用具体策略特有的接口，例如KLruKCache::markAbsent
+        template <typename Fn>
+        auto withShard(const Key &key, Fn fn) -> decltype(fn(declval<Policy &>()))
+        {
+            Shard &shard = shardOf(key);
+            lock_guard<Locking> lock(shard.lock);
+            return fn(*shard.cache);
+        }
+
+        // 所有分片的统计之和
+        KShardedStats stats() const
+        {
+            KShardedStats total;
+            for (int i = 0; i < _shardNum; i++)
+            {
+                KShardedStats one = shardStats(i);
+                total.gets += one.gets;
+                total.hits += one.hits;
+                total.puts += one.puts;
+            }
+            return total;
+        }
+
+        // 单个分片的统计（用来观察key分布是否均匀）
+        KShardedStats shardStats(int index) const
+        {
+            KShardedStats stats;
+            stats.gets = _shards[index].gets.load(memory_order_relaxed);
+            stats.hits = _shards[index].hits.load(memory_order_relaxed);
+            stats.puts = _shards[index].puts.load(memory_order_relaxed);
+            return stats;
+        }
+
+        int shardNum() const { return _shardNum; }
+
+    private:
+        Shard &shardOf(const Key &key)
+        {
+            return _shards[_hasher(key) % _shardNum];
+        }
+    };
+}
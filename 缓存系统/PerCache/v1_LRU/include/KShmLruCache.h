@@ -0,0 +1,443 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <thread>
+#include <chrono>
+#include <pthread.h>
+#include <fcntl.h>    //O_CREAT等
+#include <sys/mman.h> //shm_open、mmap
+#include <sys/stat.h> //fstat
+#include <unistd.h>   //ftruncate
+using namespace std;
+
+namespace PerCache
+{
+    // KShmLruCache类：放在共享内存中的分片LRU缓存，多个进程共用一份
+    /*
+        预先fork的多进程服务（每个worker进程一个KLruCache）的问题：命中率被分成了N份，内存也用了N份。
+        KShmLruCache把所有数据放在一块shm_open + mmap的共享内存里，所有worker进程attach同一个缓存。
+
+        共享内存在每个进程里映射到的地址不同，所以里面不能存指针：
+            节点、哈希桶、LRU链表的前驱/后继全部用uint32_t下标（相对于分片起点的偏移）表示。
+        同样的原因，Key和Value必须是可以直接按字节拷贝的类型（trivially copyable，例如int、固定长度的char数组），
+        哈希和比较也直接按字节进行（所以Key中不能有未初始化的填充字节）。
+
+        每个分片一把进程间共享的健壮互斥锁（PTHREAD_PROCESS_SHARED + PTHREAD_MUTEX_ROBUST）：
+            如果某个worker持有锁时崩溃了，下一个加锁的进程会得到EOWNERDEAD。
+            这时分片内的链表可能只改了一半，无法判断是否完整，于是直接把这个分片重置为空，再标记锁为一致（consistent）。
+            崩溃只会丢掉一个分片的缓存内容，其他分片和其他worker都不受影响。
+
+        内存布局：
+            [RegionHeader][分片0][分片1]...
+            分片 = [SliceHeader][哈希桶 uint32_t * bucketNum][节点 Node * sliceCapacity]
+    */
+    template <typename Key, typename Value>
+    class KShmLruCache
+    {
+        static_assert(is_trivially_copyable<Key>::value, "KShmLruCache requires a trivially copyable Key");
+        static_assert(is_trivially_copyable<Value>::value, "KShmLruCache requires a trivially copyable Value");
+
+    private:
+        static const uint32_t Nil = UINT32_MAX;
+        static const uint64_t Magic = 0x4B53484D4C525532ULL; // "KSHMLRU2"（哈希函数和1不同，两个版本不能共用一个段）
+
+        struct RegionHeader
+        {
+            uint64_t magic;
+            uint32_t keySize; // attach时检查Key/Value的大小和创建者一致
+            uint32_t valueSize;
+            uint32_t sliceNum;
+            uint32_t sliceCapacity;
+            uint32_t bucketNum;
+            uint64_t sliceStride;            // 每个分片占用的字节数
+            atomic<uint32_t> ready;          // 创建者初始化完成后置1
+            atomic<uint32_t> recoveredSlices; // 因worker崩溃被重置过的分片次数
+        };
+
+        struct alignas(64) SliceHeader
+        {
+            pthread_mutex_t mutex;
+            uint32_t head;     // 最久未使用
+            uint32_t tail;     // 最近使用
+            uint32_t freeHead; // 空闲节点链表（通过next串起来）
+            uint32_t size;
+        };
+
+        struct Node
+        {
+            Key key;
+            Value value;
+            uint32_t prev;
+            uint32_t next;
+            uint32_t hashNext; // 同一个哈希桶中的下一个节点
+        };
+
+        string _name;
+        void *_base = nullptr;
+        size_t _mappedSize = 0;
+        RegionHeader *_header = nullptr;
+
+    public:
+        // 按名字attach一个共享内存缓存，不存在时创建（capacity和sliceNum只在创建时使用）
+        /*
+            attach时要等创建者ftruncate并初始化完成。如果创建者在初始化完成之前崩溃了，这个段永远不会就绪，
+            等待超过attachTimeout后抛出runtime_error，调用者可以destroy(name)之后重新创建。
+        */
+        KShmLruCache(const string &name, size_t capacity, int sliceNum,
+                     chrono::milliseconds attachTimeout = chrono::seconds(5))
+            : _name(name)
+        {
+            if (sliceNum <= 0)
+                sliceNum = 1;
+            uint32_t sliceCapacity = static_cast<uint32_t>((capacity + sliceNum - 1) / sliceNum);
+            if (sliceCapacity == 0)
+                sliceCapacity = 1;
+            uint32_t bucketNum = 1;
+            while (bucketNum < sliceCapacity)
+                bucketNum <<= 1;
+            uint64_t sliceStride = alignUp(sizeof(SliceHeader) + sizeof(uint32_t) * bucketNum + sizeof(Node) * sliceCapacity, 64);
+            size_t totalSize = alignUp(sizeof(RegionHeader), 64) + sliceStride * sliceNum;
+
+            int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            bool creator = fd >= 0;
+            if (!creator)
+            {
+                if (errno != EEXIST)
+                    throw runtime_error("shm_open failed: " + name);
+                fd = shm_open(name.c_str(), O_RDWR, 0600);
+                if (fd < 0)
+                    throw runtime_error("shm_open failed: " + name);
+                // 等创建者ftruncate完成
+                struct stat st;
+                auto deadline = chrono::steady_clock::now() + attachTimeout;
+                while (fstat(fd, &st) == 0 && st.st_size == 0)
+                {
+                    if (chrono::steady_clock::now() >= deadline)
+                    {
+                        close(fd);
+                        throw runtime_error("timed out waiting for the creator of shared memory segment: " + name);
+                    }
+                    std::this_thread::sleep_for(chrono::milliseconds(1));
+                }
+                totalSize = st.st_size;
+            }
+            else if (ftruncate(fd, totalSize) != 0)
+            {
+                close(fd);
+                shm_unlink(name.c_str());
+                throw runtime_error("ftruncate failed: " + name);
+            }
+
+            _base = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (_base == MAP_FAILED)
+                throw runtime_error("mmap failed: " + name);
+            _mappedSize = totalSize;
+            _header = static_cast<RegionHeader *>(_base);
+
+            if (creator)
+            {
+                _header->magic = Magic;
+                _header->keySize = sizeof(Key);
+                _header->valueSize = sizeof(Value);
+                _header->sliceNum = sliceNum;
+                _header->sliceCapacity = sliceCapacity;
+                _header->bucketNum = bucketNum;
+                _header->sliceStride = sliceStride;
+                _header->recoveredSlices.store(0);
+                for (uint32_t i = 0; i < _header->sliceNum; i++)
+                    initializeSlice(i);
+                _header->ready.store(1, memory_order_release);
+            }
+            else
+            {
+                // 等创建者初始化完成（ftruncate出来的内存全是0，ready初始为0）
+                auto deadline = chrono::steady_clock::now() + attachTimeout;
+                while (_header->ready.load(memory_order_acquire) == 0)
+                {
+                    if (chrono::steady_clock::now() >= deadline)
+                    {
+                        munmap(_base, _mappedSize);
+                        throw runtime_error("timed out waiting for the creator of shared memory segment: " + name);
+                    }
+                    std::this_thread::sleep_for(chrono::milliseconds(1));
+                }
+                if (_header->magic != Magic || _header->keySize != sizeof(Key) || _header->valueSize != sizeof(Value))
+                {
+                    munmap(_base, _mappedSize);
+                    throw runtime_error("shared memory segment layout mismatch: " + name);
+                }
+            }
+        }
+
+        ~KShmLruCache()
+        {
+            if (_base != nullptr)
+                munmap(_base, _mappedSize);
+        }
+
+        KShmLruCache(const KShmLruCache &) = delete;
+        KShmLruCache &operator=(const KShmLruCache &) = delete;
+
+        // 删除共享内存段（已经attach的进程不受影响，全部detach后内存才释放）
+        static void destroy(const string &name)
+        {
+            shm_unlink(name.c_str());
+        }
+
+        bool get(const Key &key, Value &value)
+        {
+            uint64_t h = hashOf(key);
+            SliceHeader *slice = sliceOf(h);
+            lockSlice(slice);
+            uint32_t id = find(slice, key, h);
+            bool found = id != Nil;
+            if (found)
+            {
+                moveToMostRecent(slice, id);
+                value = nodes(slice)[id].value;
+            }
+            pthread_mutex_unlock(&slice->mutex);
+            return found;
+        }
+
+        Value get(const Key &key)
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        // 在分片锁内原地修改一个已有的元素：fn(Value &)，例如多个进程共用的计数器加1；key不存在时返回false
+        /*
+            fn在持有分片锁（进程间的健壮互斥锁）时调用，不要在里面调用这个缓存的其它函数。
+            如果fn中进程退出或崩溃，下一个加这把锁的进程会把这个分片重置为空（见lockSlice）。
+        */
+        template <typename Fn>
+        bool update(const Key &key, Fn fn)
+        {
+            uint64_t h = hashOf(key);
+            SliceHeader *slice = sliceOf(h);
+            lockSlice(slice);
+            uint32_t id = find(slice, key, h);
+            bool found = id != Nil;
+            if (found)
+            {
+                fn(nodes(slice)[id].value);
+                moveToMostRecent(slice, id);
+            }
+            pthread_mutex_unlock(&slice->mutex);
+            return found;
+        }
+
+        void put(const Key &key, const Value &value)
+        {
+            uint64_t h = hashOf(key);
+            SliceHeader *slice = sliceOf(h);
+            lockSlice(slice);
+            uint32_t id = find(slice, key, h);
+            if (id != Nil)
+            {
+                nodes(slice)[id].value = value;
+                moveToMostRecent(slice, id);
+            }
+            else
+            {
+                if (slice->freeHead == Nil)
+                    eraseNode(slice, slice->head); // 分片满了，淘汰最久未使用的节点
+                id = slice->freeHead;
+                Node &node = nodes(slice)[id];
+                slice->freeHead = node.next;
+                node.key = key;
+                node.value = value;
+                // 插入哈希桶
+                uint32_t &bucket = buckets(slice)[h & (_header->bucketNum - 1)];
+                node.hashNext = bucket;
+                bucket = id;
+                pushBack(slice, id);
+                slice->size++;
+            }
+            pthread_mutex_unlock(&slice->mutex);
+        }
+
+        void remove(const Key &key)
+        {
+            uint64_t h = hashOf(key);
+            SliceHeader *slice = sliceOf(h);
+            lockSlice(slice);
+            uint32_t id = find(slice, key, h);
+            if (id != Nil)
+                eraseNode(slice, id);
+            pthread_mutex_unlock(&slice->mutex);
+        }
+
+        size_t size()
+        {
+            size_t total = 0;
+            for (uint32_t i = 0; i < _header->sliceNum; i++)
+            {
+                SliceHeader *slice = sliceAt(i);
+                lockSlice(slice);
+                total += slice->size;
+                pthread_mutex_unlock(&slice->mutex);
+            }
+            return total;
+        }
+
+        // 因worker崩溃（持锁时退出）而被重置过的分片次数
+        uint32_t recoveredSlices() const
+        {
+            return _header->recoveredSlices.load();
+        }
+
+    private:
+        static uint64_t alignUp(uint64_t n, uint64_t align)
+        {
+            return (n + align - 1) / align * align;
+        }
+
+        // 按字节计算64位哈希（FNV-1a + murmur3的收尾混合）：std::hash不保证不同进程间结果相同，而且固定长度数组没有std::hash
+        /*
+            低32位选桶（h & (bucketNum - 1)，bucketNum不超过2^32），高32位选分片，两者用的是不重叠的位。
+            收尾混合让高位也充分依赖每个字节（FNV-1a最后一个字节只影响乘法进位能到达的位）。
+        */
+        static uint64_t hashOf(const Key &key)
+        {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(&key);
+            uint64_t h = 1469598103934665603ULL;
+            for (size_t i = 0; i < sizeof(Key); i++)
+            {
+                h ^= p[i];
+                h *= 1099511628211ULL;
+            }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        SliceHeader *sliceAt(uint32_t index)
+        {
+            char *first = static_cast<char *>(_base) + alignUp(sizeof(RegionHeader), 64);
+            return reinterpret_cast<SliceHeader *>(first + _header->sliceStride * index);
+        }
+
+        SliceHeader *sliceOf(uint64_t h)
+        {
+            // 用哈希值的高32位选分片，低32位选桶，两者互不重叠
+            return sliceAt(static_cast<uint32_t>(h >> 32) % _header->sliceNum);
+        }
+
+        uint32_t *buckets(SliceHeader *slice)
+        {
+            return reinterpret_cast<uint32_t *>(reinterpret_cast<char *>(slice) + sizeof(SliceHeader));
+        }
+
+        Node *nodes(SliceHeader *slice)
+        {
+            return reinterpret_cast<Node *>(buckets(slice) + _header->bucketNum);
+        }
+
+        // 初始化（或崩溃后重置）一个分片的数据：清空哈希桶和链表，所有节点放入空闲链表
+        void resetSlice(SliceHeader *slice)
+        {
+            slice->head = slice->tail = Nil;
+            slice->size = 0;
+            uint32_t *bucket = buckets(slice);
+            for (uint32_t i = 0; i < _header->bucketNum; i++)
+                bucket[i] = Nil;
+            Node *node = nodes(slice);
+            for (uint32_t i = 0; i < _header->sliceCapacity; i++)
+                node[i].next = i + 1 < _header->sliceCapacity ? i + 1 : Nil;
+            slice->freeHead = 0;
+        }
+
+        void initializeSlice(uint32_t index)
+        {
+            SliceHeader *slice = sliceAt(index);
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&slice->mutex, &attr);
+            pthread_mutexattr_destroy(&attr);
+            resetSlice(slice);
+        }
+
+        // 加锁；上一个持锁者崩溃时重置分片
+        void lockSlice(SliceHeader *slice)
+        {
+            int rc = pthread_mutex_lock(&slice->mutex);
+            if (rc == EOWNERDEAD)
+            {
+                resetSlice(slice);
+                pthread_mutex_consistent(&slice->mutex);
+                _header->recoveredSlices.fetch_add(1);
+            }
+        }
+
+        uint32_t find(SliceHeader *slice, const Key &key, uint64_t h)
+        {
+            Node *node = nodes(slice);
+            for (uint32_t id = buckets(slice)[h & (_header->bucketNum - 1)]; id != Nil; id = node[id].hashNext)
+            {
+                if (memcmp(&node[id].key, &key, sizeof(Key)) == 0)
+                    return id;
+            }
+            return Nil;
+        }
+
+        void pushBack(SliceHeader *slice, uint32_t id)
+        {
+            Node *node = nodes(slice);
+            node[id].prev = slice->tail;
+            node[id].next = Nil;
+            if (slice->tail != Nil)
+                node[slice->tail].next = id;
+            else
+                slice->head = id;
+            slice->tail = id;
+        }
+
+        void unlink(SliceHeader *slice, uint32_t id)
+        {
+            Node *node = nodes(slice);
+            if (node[id].prev != Nil)
+                node[node[id].prev].next = node[id].next;
+            else
+                slice->head = node[id].next;
+            if (node[id].next != Nil)
+                node[node[id].next].prev = node[id].prev;
+            else
+                slice->tail = node[id].prev;
+        }
+
+        void moveToMostRecent(SliceHeader *slice, uint32_t id)
+        {
+            if (slice->tail == id)
+                return;
+            unlink(slice, id);
+            pushBack(slice, id);
+        }
+
+        // 从哈希桶和链表中删除节点，放回空闲链表
+        void eraseNode(SliceHeader *slice, uint32_t id)
+        {
+            Node *node = nodes(slice);
+            uint32_t *link = &buckets(slice)[hashOf(node[id].key) & (_header->bucketNum - 1)];
+            while (*link != id)
+                link = &node[*link].hashNext;
+            *link = node[id].hashNext;
+            unlink(slice, id);
+            node[id].next = slice->freeHead;
+            slice->freeHead = id;
+            slice->size--;
+        }
+    };
+}
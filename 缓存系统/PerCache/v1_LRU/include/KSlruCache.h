@@ -0,0 +1,197 @@
+#pragma once
+
+#include "KLruCache.h"
+
+namespace PerCache
+{
+    // KSlruCache类：分段LRU（Segmented LRU）
+    /*
+        缓存分成两段，每段都是一条LruNode双向链表（头部最久未使用，尾部最新）：
+            试用段（probation）：新插入的key先进入这里
+            保护段（protected）：在试用段中再次被访问（命中）的key晋升到这里
+        保护段的容量 = 总容量 * protectedRatio，保护段满了以后，把保护段中最久未使用的节点降级回试用段的最新位置。
+        淘汰时优先淘汰试用段中最久未使用的节点。
+        这样一次性的扫描（每个key只访问一次）只会在试用段里轮转，不会把保护段中的热点数据挤出去。
+
+        和KLruKCache相比：
+            KLruKCache除了主缓存，还要维护一个历史计数缓存（_historyCounter）和一个历史值哈希表（_historyValueMap），
+            一次get可能要加三次锁；KSlruCache只有一个哈希表 + 两条链表，内存开销和普通LRU一样，每次操作只加一次锁。
+    */
+    template <typename Key, typename Value>
+    class KSlruCache : public KICachePolicy<Key, Value>
+    {
+    public:
+        using LruNodeType = LruNode<Key, Value>;
+        using NodePtr = shared_ptr<LruNodeType>;
+
+    private:
+        // 一段LRU链表
+        struct Segment
+        {
+            NodePtr dummyHead; // 哨兵头节点（之后是最久未使用的节点）
+            NodePtr dummyTail; // 哨兵尾节点（之前是最新的节点）
+            size_t size = 0;   // 链表中的节点个数
+        };
+        // 哈希表中的元素：节点 + 节点所在的段
+        struct Entry
+        {
+            NodePtr node;
+            bool isProtected;
+        };
+
+        int _capacity;             // 总容量
+        size_t _protectedCapacity; // 保护段容量
+        unordered_map<Key, Entry> _nodeMap;
+        Segment _probation;        // 试用段
+        Segment _protected;        // 保护段
+        mutex _mutex;
+
+    public:
+        // protectedRatio：保护段占总容量的比例
+        KSlruCache(int capacity, double protectedRatio = 0.8)
+            : _capacity(capacity)
+        {
+            if (protectedRatio < 0)
+                protectedRatio = 0;
+            if (protectedRatio > 1)
+                protectedRatio = 1;
+            _protectedCapacity = capacity > 0 ? static_cast<size_t>(capacity * protectedRatio) : 0;
+            initializeSegment(_probation);
+            initializeSegment(_protected);
+        }
+
+        void put(Key key, Value value) override
+        {
+            if (_capacity <= 0)
+                return;
+            lock_guard<mutex> lock(_mutex);
+            auto it = _nodeMap.find(key);
+            if (it != _nodeMap.end())
+            {
+                // 已存在：更新value，并按一次命中处理
+                it->second.node->setValue(value);
+                onHit(it->second);
+                return;
+            }
+            // 缓存满了，先淘汰
+            if (_nodeMap.size() >= static_cast<size_t>(_capacity))
+            {
+                evict();
+            }
+            // 新key进入试用段
+            NodePtr newNode = make_shared<LruNodeType>(key, value);
+            pushBack(_probation, newNode);
+            _nodeMap[key] = Entry{newNode, false};
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _nodeMap.find(key);
+            if (it == _nodeMap.end())
+                return false;
+            onHit(it->second);
+            value = it->second.node->getValue();
+            return true;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value; // 如果key不存在，则返回默认值
+        }
+
+        void remove(Key key)
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _nodeMap.find(key);
+            if (it != _nodeMap.end())
+            {
+                unlink(it->second.isProtected ? _protected : _probation, it->second.node);
+                _nodeMap.erase(it);
+            }
+        }
+
+        // 两段中的节点个数（主要用于测试和观察）
+        size_t probationSize()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _probation.size;
+        }
+        size_t protectedSize()
+        {
+            lock_guard<mutex> lock(_mutex);
+            return _protected.size;
+        }
+
+    private:
+        void initializeSegment(Segment &segment)
+        {
+            segment.dummyHead = make_shared<LruNodeType>(Key(), Value());
+            segment.dummyTail = make_shared<LruNodeType>(Key(), Value());
+            segment.dummyHead->_next = segment.dummyTail;
+            segment.dummyTail->_prev = segment.dummyHead;
+        }
+
+        // 命中：试用段中的节点晋升到保护段，保护段中的节点移到最新位置
+        void onHit(Entry &entry)
+        {
+            if (entry.isProtected)
+            {
+                unlink(_protected, entry.node);
+                pushBack(_protected, entry.node);
+                return;
+            }
+            unlink(_probation, entry.node);
+            if (_protectedCapacity == 0)
+            {
+                // 没有保护段，退化为普通LRU
+                pushBack(_probation, entry.node);
+                return;
+            }
+            pushBack(_protected, entry.node);
+            entry.isProtected = true;
+            // 保护段溢出：最久未使用的节点降级回试用段（作为试用段中最新的节点，还有一次机会）
+            if (_protected.size > _protectedCapacity)
+            {
+                NodePtr demoted = _protected.dummyHead->_next;
+                unlink(_protected, demoted);
+                pushBack(_probation, demoted);
+                _nodeMap[demoted->getKey()].isProtected = false;
+            }
+        }
+
+        // 淘汰：优先淘汰试用段中最久未使用的节点，试用段为空时才淘汰保护段的
+        void evict()
+        {
+            Segment &segment = _probation.size > 0 ? _probation : _protected;
+            NodePtr victim = segment.dummyHead->_next;
+            unlink(segment, victim);
+            _nodeMap.erase(victim->getKey());
+        }
+
+        // 链表操作和KLruCache的insertNode/removeNode相同，只是作用在指定的段上
+        void pushBack(Segment &segment, NodePtr node)
+        {
+            auto prev = segment.dummyTail->_prev;
+            prev.lock()->_next = node;
+            node->_next = segment.dummyTail;
+            segment.dummyTail->_prev = node;
+            node->_prev = prev;
+            segment.size++;
+        }
+
+        void unlink(Segment &segment, NodePtr node)
+        {
+            if (!node->_prev.expired() && node->_next)
+            {
+                auto prev = node->_prev.lock();
+                prev->_next = node->_next;
+                node->_next->_prev = prev;
+                node->_next = nullptr;
+                segment.size--;
+            }
+        }
+    };
+}
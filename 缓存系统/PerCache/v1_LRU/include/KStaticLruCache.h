@@ -0,0 +1,274 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>  //hash
+#include <type_traits> //conditional_t
+#include <utility>     //move
+using namespace std;
+
+namespace PerCache
+{
+    // KStaticLruCache类：容量在编译期确定、不使用堆内存的LRU缓存
+    /*
+        给每个连接/每个请求用的小缓存：KLruCache构造时要make_shared两个哨兵节点，每插入一个元素再make_shared一个节点，
+        哈希表还会扩容，建几千个小缓存时这些堆分配就成了主要开销。
+        这里所有东西都放在对象内部的std::array中：
+            _keys/_values：N个槽位，元素总是紧凑地放在[0, _size)中（删除时把最后一个槽位搬过来填洞）
+            _prev/_next：用槽位下标代替指针的双向链表，_head是最久未使用的，_tail是最新的
+            _table：开放寻址（线性探测）的哈希索引，存 槽位下标+1（0表示空桶，这样值初始化就是空表），删除用向后移动
+        N <= 16时不建哈希索引，直接线性扫描[0, _size)比较key（一两个缓存行，比算哈希值还快），也不会调用Hasher。
+        构造函数是constexpr的，N <= 16时get/put/remove也可以在编译期求值（Key/Value是字面类型时）。
+        不加锁：这种缓存只属于一个连接/请求，只会被一个线程访问。
+    */
+    template <typename Key, typename Value, size_t N, typename Hasher = hash<Key>>
+    class KStaticLruCache
+    {
+        static_assert(N > 0, "KStaticLruCache capacity must be positive");
+
+    private:
+        using Index = conditional_t<(N < 0xFFFF), uint16_t, uint32_t>; // 槽位下标（容量小时用2字节，链表和索引更紧凑）
+        static constexpr Index _nil = static_cast<Index>(-1);            // 空链接
+        static constexpr bool _linearScan = N <= 16;                     // 是否用线性扫描代替哈希索引
+
+        // 哈希索引的桶数：不小于2N的2的幂（装载因子不超过0.5）；线性扫描时不需要，只留1个
+        static constexpr size_t tableSize()
+        {
+            if (_linearScan)
+                return 1;
+            size_t size = 1;
+            while (size < 2 * N)
+                size <<= 1;
+            return size;
+        }
+        static constexpr size_t _mask = tableSize() - 1;
+
+        array<Key, N> _keys;
+        array<Value, N> _values;
+        array<uint32_t, _linearScan ? 1 : N> _hashes; // 每个槽位key的哈希值（低32位），索引删除/移动时不用重新计算
+        array<Index, N> _prev;
+        array<Index, N> _next;
+        array<Index, tableSize()> _table; // 槽位下标+1，0表示空桶
+        size_t _size;
+        Index _head; // 最久未使用
+        Index _tail; // 最新
+
+    public:
+        constexpr KStaticLruCache()
+            : _keys{}, _values{}, _hashes{}, _prev{}, _next{}, _table{}, _size(0), _head(_nil), _tail(_nil)
+        {
+        }
+
+        // put添加缓存：已存在则更新value并移到最新位置；满了就复用最久未使用的槽位
+        constexpr void put(const Key &key, const Value &value)
+        {
+            uint32_t hashValue = hashOf(key);
+            size_t slot = findSlot(key, hashValue);
+            if (slot != _nil)
+            {
+                _values[slot] = value;
+                touch(slot);
+                return;
+            }
+            if (_size == N)
+            {
+                slot = _head; // 淘汰最久未使用的，直接复用它的槽位，元素仍然是紧凑的
+                unlink(slot);
+                eraseIndex(slot);
+            }
+            else
+            {
+                slot = _size++;
+            }
+            _keys[slot] = key;
+            _values[slot] = value;
+            if constexpr (!_linearScan)
+                _hashes[slot] = hashValue;
+            linkTail(slot);
+            insertIndex(slot);
+        }
+
+        // get查询key，存在时填充value并移到最新位置
+        constexpr bool get(const Key &key, Value &value)
+        {
+            size_t slot = findSlot(key, hashOf(key));
+            if (slot == _nil)
+                return false;
+            touch(slot);
+            value = _values[slot];
+            return true;
+        }
+
+        constexpr Value get(const Key &key)
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        // 删除key（最后一个槽位搬到空出来的位置）
+        constexpr bool remove(const Key &key)
+        {
+            size_t slot = findSlot(key, hashOf(key));
+            if (slot == _nil)
+                return false;
+            unlink(slot);
+            eraseIndex(slot);
+            size_t last = --_size;
+            if (slot != last)
+                moveSlot(last, slot);
+            _keys[last] = Key();     // 释放key/value持有的资源（例如string的堆内存）
+            _values[last] = Value();
+            return true;
+        }
+
+        constexpr void clear()
+        {
+            for (size_t i = 0; i < _size; i++)
+            {
+                _keys[i] = Key();
+                _values[i] = Value();
+            }
+            for (auto &bucket : _table)
+                bucket = 0;
+            _size = 0;
+            _head = _tail = _nil;
+        }
+
+        constexpr size_t size() const { return _size; }
+        static constexpr size_t capacity() { return N; }
+
+    private:
+        constexpr uint32_t hashOf(const Key &key) const
+        {
+            if constexpr (_linearScan)
+                return 0;
+            else
+                return static_cast<uint32_t>(Hasher()(key));
+        }
+
+        // 查找key所在的槽位，没有返回_nil
+        constexpr size_t findSlot(const Key &key, uint32_t hashValue) const
+        {
+            if constexpr (_linearScan)
+            {
+                for (size_t i = 0; i < _size; i++)
+                {
+                    if (_keys[i] == key)
+                        return i;
+                }
+                return _nil;
+            }
+            else
+            {
+                for (size_t i = hashValue & _mask; _table[i] != 0; i = (i + 1) & _mask)
+                {
+                    size_t slot = _table[i] - 1;
+                    if (_hashes[slot] == hashValue && _keys[slot] == key)
+                        return slot;
+                }
+                return _nil;
+            }
+        }
+
+        // 槽位在哈希索引中的桶
+        constexpr size_t bucketOf(size_t slot) const
+        {
+            size_t i = _hashes[slot] & _mask;
+            while (_table[i] != slot + 1)
+                i = (i + 1) & _mask;
+            return i;
+        }
+
+        constexpr void insertIndex(size_t slot)
+        {
+            if constexpr (!_linearScan)
+            {
+                size_t i = _hashes[slot] & _mask;
+                while (_table[i] != 0)
+                    i = (i + 1) & _mask;
+                _table[i] = static_cast<Index>(slot + 1);
+            }
+        }
+
+        // 从哈希索引中删除槽位：向后移动删除，探测链上后面的元素往前补，不留墓碑
+        constexpr void eraseIndex(size_t slot)
+        {
+            if constexpr (!_linearScan)
+            {
+                size_t hole = bucketOf(slot);
+                for (size_t i = (hole + 1) & _mask; _table[i] != 0; i = (i + 1) & _mask)
+                {
+                    size_t home = _hashes[_table[i] - 1] & _mask;
+                    // i处的元素可以移到hole：它的理想位置home不在(hole, i]之间
+                    if (((i - home) & _mask) >= ((i - hole) & _mask))
+                    {
+                        _table[hole] = _table[i];
+                        hole = i;
+                    }
+                }
+                _table[hole] = 0;
+            }
+        }
+
+        // 把槽位from的元素搬到to（to已经空出来），修改链表和索引中指向它的地方
+        constexpr void moveSlot(size_t from, size_t to)
+        {
+            _keys[to] = move(_keys[from]);
+            _values[to] = move(_values[from]);
+            if constexpr (!_linearScan)
+            {
+                _hashes[to] = _hashes[from];
+                _table[bucketOf(from)] = static_cast<Index>(to + 1);
+            }
+            _prev[to] = _prev[from];
+            _next[to] = _next[from];
+            if (_prev[to] != _nil)
+                _next[_prev[to]] = static_cast<Index>(to);
+            else
+                _head = static_cast<Index>(to);
+            if (_next[to] != _nil)
+                _prev[_next[to]] = static_cast<Index>(to);
+            else
+                _tail = static_cast<Index>(to);
+        }
+
+        // 链表中摘下槽位
+        constexpr void unlink(size_t slot)
+        {
+            Index prev = _prev[slot];
+            Index next = _next[slot];
+            if (prev != _nil)
+                _next[prev] = next;
+            else
+                _head = next;
+            if (next != _nil)
+                _prev[next] = prev;
+            else
+                _tail = prev;
+        }
+
+        // 槽位插到链表尾部（最新位置）
+        constexpr void linkTail(size_t slot)
+        {
+            _prev[slot] = _tail;
+            _next[slot] = _nil;
+            if (_tail != _nil)
+                _next[_tail] = static_cast<Index>(slot);
+            else
+                _head = static_cast<Index>(slot);
+            _tail = static_cast<Index>(slot);
+        }
+
+        // 移到最新位置
+        constexpr void touch(size_t slot)
+        {
+            if (slot != _tail)
+            {
+                unlink(slot);
+                linkTail(slot);
+            }
+        }
+    };
+}
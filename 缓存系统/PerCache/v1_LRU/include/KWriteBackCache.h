@@ -0,0 +1,330 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "KLruCache.h"
+using namespace std;
+
+namespace PerCache
+{
+    // 后端存储接口：KWriteBackCache未命中时从这里读，脏数据成批写回这里
+    template <typename Key, typename Value>
+    class KBackingStore
+    {
+    public:
+        virtual ~KBackingStore() {}
+        virtual bool read(const Key &key, Value &value) = 0;
+        // 一次写入一批（同一批中key不重复）
+        virtual void writeBatch(const vector<pair<Key, Value>> &batch) = 0;
+    };
+
+    // KFileBackingStore类：写到本地文件的后端存储（测试用）
+    /*
+        文件是只追加的日志，每次writeBatch把一批记录拼好以后一次写入并fflush，每条记录：
+            key的长度 空格 key value的长度 空格 value 换行
+        key/value用<<转换成文本（string原样写入），所以可以包含空格、换行。
+        打开时把已有的日志读一遍（后面的记录覆盖前面的），之后读请求直接查内存中的表。
+    */
+    template <typename Key, typename Value>
+    class KFileBackingStore : public KBackingStore<Key, Value>
+    {
+    private:
+        FILE *_file;
+        mutex _mutex;
+        unordered_map<Key, Value> _data;
+        atomic<uint64_t> _batches{0}; // writeBatch被调用的次数（= 写文件的次数）
+        atomic<uint64_t> _records{0}; // 写入的记录条数
+
+    public:
+        explicit KFileBackingStore(const string &path)
+        {
+            replay(path);
+            _file = fopen(path.c_str(), "ab");
+        }
+
+        ~KFileBackingStore()
+        {
+            if (_file != nullptr)
+                fclose(_file);
+        }
+
+        KFileBackingStore(const KFileBackingStore &) = delete;
+        KFileBackingStore &operator=(const KFileBackingStore &) = delete;
+
+        bool read(const Key &key, Value &value) override
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto it = _data.find(key);
+            if (it == _data.end())
+                return false;
+            value = it->second;
+            return true;
+        }
+
+        void writeBatch(const vector<pair<Key, Value>> &batch) override
+        {
+            if (batch.empty())
+                return;
+            string buffer;
+            for (auto &entry : batch)
+            {
+                appendField(buffer, toText(entry.first));
+                buffer += ' ';
+                appendField(buffer, toText(entry.second));
+                buffer += '\n';
+            }
+            lock_guard<mutex> lock(_mutex);
+            if (_file != nullptr)
+            {
+                fwrite(buffer.data(), 1, buffer.size(), _file);
+                fflush(_file);
+            }
+            for (auto &entry : batch)
+                _data[entry.first] = entry.second;
+            _batches++;
+            _records += batch.size();
+        }
+
+        uint64_t batchCount() const { return _batches; }
+        uint64_t recordCount() const { return _records; }
+
+    private:
+        template <typename T>
+        static string toText(const T &item)
+        {
+            ostringstream out;
+            out << item;
+            return out.str();
+        }
+        static string toText(const string &item) { return item; }
+
+        template <typename T>
+        static void fromText(const string &text, T &item)
+        {
+            istringstream in(text);
+            in >> item;
+        }
+        static void fromText(const string &text, string &item) { item = text; }
+
+        static void appendField(string &buffer, const string &text)
+        {
+            buffer += to_string(text.size());
+            buffer += ' ';
+            buffer += text;
+        }
+
+        // 读出一个字段，失败（文件末尾、最后一条记录写了一半）返回false
+        static bool readField(FILE *file, string &text)
+        {
+            size_t length = 0;
+            if (fscanf(file, "%zu", &length) != 1 || fgetc(file) != ' ')
+                return false;
+            text.resize(length);
+            return length == 0 || fread(&text[0], 1, length, file) == length;
+        }
+
+        void replay(const string &path)
+        {
+            FILE *file = fopen(path.c_str(), "rb");
+            if (file == nullptr)
+                return;
+            string keyText, valueText;
+            while (readField(file, keyText) && fgetc(file) == ' ' && readField(file, valueText) && fgetc(file) == '\n')
+            {
+                Key key{};
+                Value value{};
+                fromText(keyText, key);
+                fromText(valueText, value);
+                _data[key] = value;
+            }
+            fclose(file);
+        }
+    };
+
+    // KWriteBackCache类：写回（write-back）模式的LRU缓存
+    /*
+        put只写缓存并把key标记为脏（记在_dirty中），不同步写后端存储；
+        后台刷写线程每隔flushInterval把所有脏数据作为一批写回后端存储。
+        同一个key在一个刷写间隔内被写了多少次，_dirty中都只有最新的一份，所以只写回一次（合并写）：
+        后端存储的写入次数从"每次更新一次"降到"每个刷写间隔一次"。
+        脏数据被LRU淘汰时（见KLruCache::setEvictionListener），在触发淘汰的put返回之前先把它写回，不会丢失。
+
+        一致性：
+            get未命中时，先查_dirty和正在写回的_inflight，再读后端存储，所以不会读到比缓存里更旧的值；
+            从后端读到的值用putIfAbsent放进缓存，不会覆盖同时写入的新值。
+            读后端存储不持锁，期间这个key可能被put、淘汰并写回，读到的值就过时了：
+            每次put给key所在的分段版本号加1，get在查_dirty时记下版本号，putIfAbsent之后再比较，
+            版本号变了就把刚放进缓存的值删掉（最新的值在_dirty、_inflight或后端存储中，下次get会读到）。
+            版本号按key的哈希分成_versionStripes段，不为每个key单独记录；同一段中别的key被写入只会多删一次。
+            同一段的put持有_putMutexes中同一个锁，"写_dirty + 写缓存"整体串行：否则两个线程并发put同一个key时，
+            _dirty（最终写回后端）和缓存中可能留下不同的值，直到这个key被淘汰。
+            所有写回都持有_flushMutex，并且"取出脏数据 + 写入后端"在同一次持锁内完成，
+            所以同一个key较新的值一定比较旧的值后写入后端存储。
+        析构时停止刷写线程，并把剩下的脏数据全部写回。
+    */
+    template <typename Key, typename Value>
+    class KWriteBackCache : public KICachePolicy<Key, Value>
+    {
+    private:
+        KLruCache<Key, Value> _cache;
+        shared_ptr<KBackingStore<Key, Value>> _store;
+        mutex _dirtyMutex;
+        unordered_map<Key, Value> _dirty;    // 还没写回的最新值
+        unordered_map<Key, Value> _inflight; // 正在写回的一批
+        static const size_t _versionStripes = 64;
+        uint64_t _versions[_versionStripes] = {}; // 每段的写入次数，由_dirtyMutex保护
+        mutex _putMutexes[_versionStripes];       // 每段一个，同一个key的put按同一顺序写_dirty和缓存
+        mutex _flushMutex;                   // 同一时间只有一个写回
+        chrono::milliseconds _flushInterval;
+        thread _flusher;
+        mutex _stopMutex;
+        condition_variable _stopCv;
+        bool _stop = false;
+
+    public:
+        KWriteBackCache(int capacity, shared_ptr<KBackingStore<Key, Value>> store,
+                        chrono::milliseconds flushInterval = chrono::milliseconds(100))
+            : _cache(capacity), _store(move(store)), _flushInterval(flushInterval)
+        {
+            _cache.setEvictionListener([this](const Key &key, const Value &)
+                                       { flushKey(key); });
+            _flusher = thread([this]()
+                              {
+                                  unique_lock<mutex> lock(_stopMutex);
+                                  while (!_stopCv.wait_for(lock, _flushInterval, [this]() { return _stop; }))
+                                  {
+                                      lock.unlock();
+                                      flush();
+                                      lock.lock();
+                                  } });
+        }
+
+        ~KWriteBackCache()
+        {
+            {
+                lock_guard<mutex> lock(_stopMutex);
+                _stop = true;
+            }
+            _stopCv.notify_all();
+            _flusher.join();
+            flush();
+        }
+
+        void put(Key key, Value value) override
+        {
+            size_t stripe = stripeOf(key);
+            lock_guard<mutex> putLock(_putMutexes[stripe]); // 淘汰监听器只加_flushMutex和_dirtyMutex，不会反过来等这个锁
+            {
+                lock_guard<mutex> lock(_dirtyMutex);
+                _dirty[key] = value; // 合并：同一个key只保留最新的值
+                _versions[stripe]++;
+            }
+            _cache.put(key, value); // 可能淘汰别的脏数据，淘汰监听器会先把它写回
+        }
+
+        bool get(Key key, Value &value) override
+        {
+            if (_cache.get(key, value))
+                return true;
+            size_t stripe = stripeOf(key);
+            uint64_t version;
+            {
+                lock_guard<mutex> lock(_dirtyMutex);
+                version = _versions[stripe];
+                auto it = _dirty.find(key);
+                if (it != _dirty.end())
+                {
+                    value = it->second;
+                    return true;
+                }
+                it = _inflight.find(key);
+                if (it != _inflight.end())
+                {
+                    value = it->second;
+                    return true;
+                }
+            }
+            if (!_store->read(key, value))
+                return false;
+            if (!_cache.putIfAbsent(key, value)) // 干净的数据，不标记为脏
+                return true;
+            bool stale;
+            {
+                lock_guard<mutex> lock(_dirtyMutex);
+                stale = _versions[stripe] != version;
+            }
+            if (stale)
+            {
+                // 读后端期间有写入：这次返回读到的值（和写入并发，两种顺序都可以），但不留在缓存里
+                _cache.remove(key);
+            }
+            return true;
+        }
+
+        Value get(Key key) override
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        // 立即把所有脏数据作为一批写回
+        void flush()
+        {
+            lock_guard<mutex> flushLock(_flushMutex);
+            vector<pair<Key, Value>> batch;
+            {
+                lock_guard<mutex> lock(_dirtyMutex);
+                if (_dirty.empty())
+                    return;
+                _inflight.swap(_dirty);
+                batch.assign(_inflight.begin(), _inflight.end());
+            }
+            _store->writeBatch(batch);
+            lock_guard<mutex> lock(_dirtyMutex);
+            _inflight.clear();
+        }
+
+        // 还没写回的脏数据个数
+        size_t dirtyCount()
+        {
+            lock_guard<mutex> lock(_dirtyMutex);
+            return _dirty.size();
+        }
+
+    private:
+        static size_t stripeOf(const Key &key)
+        {
+            return hash<Key>()(key) % _versionStripes;
+        }
+
+        // 被淘汰的key如果是脏的，马上单独写回（在淘汰它的put的线程中，锁外）
+        void flushKey(const Key &key)
+        {
+            lock_guard<mutex> flushLock(_flushMutex);
+            vector<pair<Key, Value>> batch;
+            {
+                lock_guard<mutex> lock(_dirtyMutex);
+                auto it = _dirty.find(key);
+                if (it == _dirty.end())
+                    return;
+                batch.emplace_back(it->first, it->second);
+                _inflight.insert(*it); // 写回完成之前，get仍然能从_inflight读到它
+                _dirty.erase(it);
+            }
+            _store->writeBatch(batch);
+            lock_guard<mutex> lock(_dirtyMutex);
+            _inflight.erase(key);
+        }
+    };
+}
@@ -0,0 +1,253 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "KCacheProtocol.h"
+#include "KPerfCounters.h"
+
+using namespace std;
+using namespace PerCache;
+
+/*
+    percache-bench：percache-server的本机压测客户端
+        每个连接一个线程，每轮连续发送pipeline个请求（一次write），再读回pipeline个响应
+    用法：
+        percache-bench (--port N | --unix PATH) [--conns 4] [--pipeline 16] [--requests 100000]
+                       [--keys 10000] [--value-size 64] [--set-ratio 10] [--mget 0] [--perf 0]
+        --set-ratio：SET请求的百分比；--mget N：N>0时读请求改为一次MGET N个key
+        --perf 1：同时统计客户端进程的性能计数器（见KPerfCounters），按每个请求输出；
+                  服务器端的计数器可以用percache-cachebench在进程内单独测量缓存本身
+*/
+
+struct Options
+{
+    string unixPath;
+    int port = 0;
+    int conns = 4;
+    int pipeline = 16;
+    long requests = 100000; // 每个连接的请求数
+    int keys = 10000;
+    int valueSize = 64;
+    int setRatio = 10;
+    int mget = 0;
+    bool perf = false;
+};
+
+static int connectServer(const Options &opt)
+{
+    int fd;
+    if (!opt.unixPath.empty())
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, opt.unixPath.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool writeAll(int fd, const string &data)
+{
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0)
+            return false;
+        written += n;
+    }
+    return true;
+}
+
+// 读回count个完整响应，统计命中次数
+static bool readResponses(int fd, int count, vector<char> &buffer, long &hits)
+{
+    size_t start = 0, end = 0;
+    while (count > 0)
+    {
+        while (end - start >= KHeaderSize)
+        {
+            KCacheHeader header = decodeHeader(buffer.data() + start);
+            if (end - start < KHeaderSize + header.bodyLen)
+                break;
+            // 统计字段中的命中数
+            const char *body = buffer.data() + start + KHeaderSize;
+            size_t offset = 0;
+            for (uint16_t i = 0; i < header.count; i++)
+            {
+                hits += body[offset] == KStatusOk ? 1 : 0;
+                offset += 1 + sizeof(uint32_t) + readU32(body + offset + 1);
+            }
+            start += KHeaderSize + header.bodyLen;
+            if (--count == 0)
+                return true;
+        }
+        if (start > 0)
+        {
+            memmove(buffer.data(), buffer.data() + start, end - start);
+            end -= start;
+            start = 0;
+        }
+        if (end == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        ssize_t n = read(fd, buffer.data() + end, buffer.size() - end);
+        if (n <= 0)
+            return false;
+        end += n;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string name = argv[i];
+        string value = argv[i + 1];
+        if (name == "--unix")
+            opt.unixPath = value;
+        else if (name == "--port")
+            opt.port = stoi(value);
+        else if (name == "--conns")
+            opt.conns = stoi(value);
+        else if (name == "--pipeline")
+            opt.pipeline = stoi(value);
+        else if (name == "--requests")
+            opt.requests = stol(value);
+        else if (name == "--keys")
+            opt.keys = stoi(value);
+        else if (name == "--value-size")
+            opt.valueSize = stoi(value);
+        else if (name == "--set-ratio")
+            opt.setRatio = stoi(value);
+        else if (name == "--mget")
+            opt.mget = stoi(value);
+        else if (name == "--perf")
+            opt.perf = stoi(value) != 0;
+    }
+    if (opt.unixPath.empty() && opt.port <= 0)
+    {
+        cerr << "usage: percache-bench (--port N | --unix PATH) [--conns N] [--pipeline N] [--requests N] "
+                "[--keys N] [--value-size N] [--set-ratio PCT] [--mget N] [--perf 0|1]"
+             << endl;
+        return 1;
+    }
+
+    atomic<long> totalOps{0}, totalHits{0}, failed{0};
+    vector<vector<double>> latencies(opt.conns); // 每轮（一批流水线请求）的往返耗时，微秒
+    unique_ptr<KPerfCounters> perf;
+    if (opt.perf)
+    {
+        perf.reset(new KPerfCounters());
+        perf->start();
+    }
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int c = 0; c < opt.conns; c++)
+    {
+        threads.emplace_back([&, c]()
+                             {
+            int fd = connectServer(opt);
+            if (fd < 0)
+            {
+                failed++;
+                return;
+            }
+            mt19937 rng(c + 1);
+            string request, value(opt.valueSize, 'v');
+            vector<string> fields(max(2, opt.mget));
+            vector<char> buffer(64 * 1024);
+            long hits = 0, ops = 0;
+            for (long done = 0; done < opt.requests; done += opt.pipeline)
+            {
+                request.clear();
+                for (int p = 0; p < opt.pipeline; p++)
+                {
+                    if (static_cast<int>(rng() % 100) < opt.setRatio)
+                    {
+                        fields[0] = "key:" + to_string(rng() % opt.keys);
+                        fields[1] = value;
+                        encodeRequest(request, KOpSet, fields.data(), 2);
+                    }
+                    else if (opt.mget > 0)
+                    {
+                        for (int k = 0; k < opt.mget; k++)
+                            fields[k] = "key:" + to_string(rng() % opt.keys);
+                        encodeRequest(request, KOpMGet, fields.data(), opt.mget);
+                    }
+                    else
+                    {
+                        fields[0] = "key:" + to_string(rng() % opt.keys);
+                        encodeRequest(request, KOpGet, fields.data(), 1);
+                    }
+                }
+                auto roundStart = chrono::steady_clock::now();
+                if (!writeAll(fd, request) || !readResponses(fd, opt.pipeline, buffer, hits))
+                {
+                    failed++;
+                    break;
+                }
+                latencies[c].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - roundStart).count());
+                ops += opt.pipeline;
+            }
+            close(fd);
+            totalOps += ops;
+            totalHits += hits; });
+    }
+    for (auto &t : threads)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    KPerfSample sample;
+    if (perf)
+        sample = perf->stop();
+
+    vector<double> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+    auto percentile = [&all](double p)
+    { return all.empty() ? 0.0 : all[min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+
+    cout << "connections: " << opt.conns << ", pipeline: " << opt.pipeline << ", failed connections: " << failed << endl;
+    cout << "requests: " << totalOps << ", hits: " << totalHits << endl;
+    cout << "throughput: " << totalOps / seconds << " req/s" << endl;
+    cout << "round trip (us, one pipeline batch): p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+         << ", p999 " << percentile(0.999) << endl;
+    if (perf)
+    {
+        cout << "client counters (hardware: " << (perf->hardwareAvailable() ? "yes" : "no, software timers only") << ")" << endl;
+        sample.report(cout, "client", totalOps);
+    }
+    return failed == 0 ? 0 : 1;
+}
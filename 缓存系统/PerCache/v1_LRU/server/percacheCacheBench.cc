@@ -0,0 +1,125 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <random>
+#include <memory>
+#include "KLruCache.h"
+#include "KFcLruCache.h"
+#include "KPerfCounters.h"
+
+using namespace std;
+using namespace PerCache;
+
+/*
+    percache-cachebench：进程内直接压测缓存本身（不经过网络），用来比较KLruCache等实现的改动
+        三个阶段：fill（写满缓存）、get（只读，全部命中）、mixed（按--set-ratio混合读写，key范围是容量的2倍）
+        每个阶段前后读取性能计数器（见KPerfCounters），按每次操作输出cycles/instructions/缓存未命中/分支预测失败
+    用法：
+        percache-cachebench [--cache lru|hash|fc] [--threads 1] [--capacity 100000] [--ops 1000000]
+                            [--set-ratio 10] [--slices 8] [--perf 1]
+        --ops：每个线程每个阶段的操作数；--perf 0：只用软件计时（不打开硬件计数器）
+*/
+
+struct Options
+{
+    string cache = "lru";
+    int threads = 1;
+    int capacity = 100000;
+    long ops = 1000000;
+    int setRatio = 10;
+    int slices = 8;
+    bool perf = true;
+};
+
+// 多线程跑一个阶段：body(线程编号, 随机数生成器)
+template <typename Body>
+void runPhase(const Options &opt, KPerfCounters &perf, const string &name, Body body)
+{
+    perf.start();
+    vector<thread> threads;
+    for (int t = 0; t < opt.threads; t++)
+        threads.emplace_back([&, t]()
+                             {
+                                 mt19937 rng(t + 1);
+                                 body(t, rng); });
+    for (auto &th : threads)
+        th.join();
+    KPerfSample sample = perf.stop();
+    sample.report(cout, name, static_cast<uint64_t>(opt.ops) * opt.threads);
+}
+
+template <typename Cache>
+void benchmark(Cache &cache, const Options &opt)
+{
+    KPerfCounters perf(opt.perf);
+    cout << "cache: " << opt.cache << ", threads: " << opt.threads << ", capacity: " << opt.capacity
+         << ", hardware counters: " << (perf.hardwareAvailable() ? "yes" : "no (software timers only)") << endl;
+
+    runPhase(opt, perf, "fill", [&](int t, mt19937 &)
+             {
+                 for (long i = 0; i < opt.ops; i++)
+                     cache.put(static_cast<int>((i * opt.threads + t) % opt.capacity), static_cast<int>(i)); });
+    runPhase(opt, perf, "get", [&](int, mt19937 &rng)
+             {
+                 int value = 0;
+                 for (long i = 0; i < opt.ops; i++)
+                     cache.get(static_cast<int>(rng() % opt.capacity), value); });
+    runPhase(opt, perf, "mixed", [&](int, mt19937 &rng)
+             {
+                 int value = 0;
+                 for (long i = 0; i < opt.ops; i++)
+                 {
+                     int key = static_cast<int>(rng() % (2 * opt.capacity));
+                     if (static_cast<int>(rng() % 100) < opt.setRatio || !cache.get(key, value))
+                         cache.put(key, key);
+                 } });
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string name = argv[i];
+        string value = argv[i + 1];
+        if (name == "--cache")
+            opt.cache = value;
+        else if (name == "--threads")
+            opt.threads = stoi(value);
+        else if (name == "--capacity")
+            opt.capacity = stoi(value);
+        else if (name == "--ops")
+            opt.ops = stol(value);
+        else if (name == "--set-ratio")
+            opt.setRatio = stoi(value);
+        else if (name == "--slices")
+            opt.slices = stoi(value);
+        else if (name == "--perf")
+            opt.perf = stoi(value) != 0;
+    }
+    if (opt.threads <= 0 || opt.capacity <= 0 || opt.ops <= 0)
+    {
+        cerr << "usage: percache-cachebench [--cache lru|hash|fc] [--threads N] [--capacity N] [--ops N] "
+                "[--set-ratio PCT] [--slices N] [--perf 0|1]"
+             << endl;
+        return 1;
+    }
+
+    if (opt.cache == "hash")
+    {
+        KHashLruCaches<int, int> cache(opt.capacity, opt.slices);
+        benchmark(cache, opt);
+    }
+    else if (opt.cache == "fc")
+    {
+        KFcLruCache<int, int> cache(opt.capacity);
+        benchmark(cache, opt);
+    }
+    else
+    {
+        KLruCache<int, int> cache(opt.capacity);
+        benchmark(cache, opt);
+    }
+    return 0;
+}
@@ -0,0 +1,492 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <climits>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "KLruCache.h"
+#include "KCacheProtocol.h"
+
+using namespace std;
+using namespace PerCache;
+
+/*
+    percache-server：把一个KHashLruCaches<string, string>共享给本机的多个进程使用
+        每个CPU核心一个线程，每个线程一个epoll循环
+        回环TCP：每个线程一个监听socket（SO_REUSEPORT，由内核把连接分散到各个线程）
+        Unix域套接字：所有线程共享一个监听socket（EPOLLEXCLUSIVE，一个新连接只唤醒一个线程）
+        支持流水线：一次读到的所有完整请求依次处理，响应攒成一批，用一次writev发出
+        每个连接的读缓冲区、响应缓冲区、value缓冲区都是复用的，解析请求时不做任何内存分配
+    用法：
+        percache-server --port 7379 [--threads N] [--capacity N] [--slices N]
+        percache-server --unix /tmp/percache.sock [--threads N] [--capacity N] [--slices N]
+*/
+
+using Cache = KHashLruCaches<string, string>;
+
+static atomic<bool> g_stop{false};
+
+// 一个客户端连接
+struct Connection
+{
+    // 响应中的一段数据：要么在out中（响应头、字段的status和len），要么是values中的一个value
+    struct Segment
+    {
+        bool isValue;
+        size_t index; // isValue时是values的下标，否则是out中的偏移
+        size_t len;
+    };
+
+    int fd;
+    vector<char> in;        // 读缓冲区（复用）
+    size_t inStart = 0;     // 还没处理的数据起点
+    size_t inEnd = 0;       // 已读入数据的终点
+    string out;             // 本批响应中的固定部分（复用）
+    vector<Segment> segments;
+    vector<string> values;  // get到的value（复用，string的容量会保留下来）
+    size_t valueCount = 0;  // 本批用到的values个数
+    string key;             // 解析出的key（复用）
+    string value;           // 解析出的value（复用）
+    vector<char> found;     // MGET中每个key是否命中（复用）
+    string pending;         // writev没写完的剩余数据，等EPOLLOUT再写
+    vector<iovec> iov;
+
+    explicit Connection(int fd) : fd(fd), in(64 * 1024) {}
+
+    // 取一个空闲的value缓冲区
+    string &nextValue()
+    {
+        if (valueCount == values.size())
+            values.emplace_back();
+        return values[valueCount++];
+    }
+
+    void appendFixed(const void *data, size_t len)
+    {
+        segments.push_back(Segment{false, out.size(), len});
+        out.append(static_cast<const char *>(data), len);
+    }
+
+    void appendValue(size_t index)
+    {
+        segments.push_back(Segment{true, index, values[index].size()});
+    }
+};
+
+// 在响应中追加一个字段：status + len + value
+static void appendField(Connection &conn, uint8_t status, size_t valueIndex)
+{
+    char prefix[5];
+    uint32_t len = status == KStatusOk ? conn.values[valueIndex].size() : 0;
+    prefix[0] = static_cast<char>(status);
+    memcpy(prefix + 1, &len, sizeof(len));
+    conn.appendFixed(prefix, sizeof(prefix));
+    if (len > 0)
+        conn.appendValue(valueIndex);
+}
+
+static void appendHeader(Connection &conn, uint8_t status, uint16_t count, uint32_t bodyLen)
+{
+    char header[KHeaderSize];
+    encodeHeader(header, status, count, bodyLen);
+    conn.appendFixed(header, KHeaderSize);
+}
+
+// 处理一个完整的请求（body指向请求体），返回false表示协议错误
+static bool handleRequest(Cache &cache, Connection &conn, const KCacheHeader &header, const char *body)
+{
+    KFieldReader reader{body, header.bodyLen};
+    const char *data;
+    uint32_t len;
+    switch (header.code)
+    {
+    case KOpGet:
+    {
+        if (header.count != 1 || !reader.next(data, len))
+            return false;
+        conn.key.assign(data, len);
+        size_t index = conn.valueCount;
+        string &value = conn.nextValue();
+        bool found = cache.get(conn.key, value);
+        appendHeader(conn, found ? KStatusOk : KStatusNotFound, 1, 5 + (found ? value.size() : 0));
+        appendField(conn, found ? KStatusOk : KStatusNotFound, index);
+        return true;
+    }
+    case KOpSet:
+        if (header.count != 2 || !reader.next(data, len))
+            return false;
+        conn.key.assign(data, len);
+        if (!reader.next(data, len))
+            return false;
+        conn.value.assign(data, len);
+        cache.put(conn.key, conn.value);
+        appendHeader(conn, KStatusOk, 0, 0);
+        return true;
+    case KOpDel:
+        if (header.count != 1 || !reader.next(data, len))
+            return false;
+        conn.key.assign(data, len);
+        cache.remove(conn.key);
+        appendHeader(conn, KStatusOk, 0, 0);
+        return true;
+    case KOpMGet:
+    {
+        // 先查出所有value，才能算出响应体长度
+        size_t first = conn.valueCount;
+        uint32_t bodyLen = 0;
+        conn.found.clear();
+        for (uint16_t i = 0; i < header.count; i++)
+        {
+            if (!reader.next(data, len))
+                return false;
+            conn.key.assign(data, len);
+            string &value = conn.nextValue();
+            bool found = cache.get(conn.key, value);
+            conn.found.push_back(found);
+            bodyLen += 5 + (found ? value.size() : 0);
+        }
+        appendHeader(conn, KStatusOk, header.count, bodyLen);
+        for (uint16_t i = 0; i < header.count; i++)
+            appendField(conn, conn.found[i] ? KStatusOk : KStatusNotFound, first + i);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// 把本批响应发出去：一次writev，没写完的部分拷到pending中等EPOLLOUT
+static bool flushResponses(int epollFd, Connection &conn)
+{
+    if (conn.segments.empty())
+        return true;
+    size_t total = 0;
+    conn.iov.clear();
+    for (auto &segment : conn.segments)
+    {
+        const char *data = segment.isValue ? conn.values[segment.index].data() : conn.out.data() + segment.index;
+        conn.iov.push_back(iovec{const_cast<char *>(data), segment.len});
+        total += segment.len;
+    }
+
+    size_t written = 0;
+    if (conn.pending.empty()) // 前面还有没写完的数据时，不能插队
+    {
+        size_t start = 0;
+        while (start < conn.iov.size())
+        {
+            int iovCount = static_cast<int>(min<size_t>(conn.iov.size() - start, IOV_MAX));
+            ssize_t n = writev(conn.fd, conn.iov.data() + start, iovCount);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            written += n;
+            // 跳过已经完整写出的iovec
+            size_t left = n;
+            while (start < conn.iov.size() && left >= conn.iov[start].iov_len)
+            {
+                left -= conn.iov[start].iov_len;
+                start++;
+            }
+            if (left > 0)
+                break; // 部分写入，说明发送缓冲区满了
+        }
+    }
+
+    if (written < total)
+    {
+        // 把剩余的数据拷贝到pending
+        size_t skip = written;
+        for (auto &vec : conn.iov)
+        {
+            if (skip >= vec.iov_len)
+            {
+                skip -= vec.iov_len;
+                continue;
+            }
+            conn.pending.append(static_cast<char *>(vec.iov_base) + skip, vec.iov_len - skip);
+            skip = 0;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.ptr = &conn;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    }
+    conn.segments.clear();
+    conn.out.clear();
+    conn.valueCount = 0;
+    return true;
+}
+
+// EPOLLOUT：继续写pending
+static bool writePending(int epollFd, Connection &conn)
+{
+    while (!conn.pending.empty())
+    {
+        ssize_t n = write(conn.fd, conn.pending.data(), conn.pending.size());
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        conn.pending.erase(0, n);
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &conn;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    return true;
+}
+
+// EPOLLIN：读数据，处理所有完整的请求（流水线），然后批量发送响应
+static bool readRequests(Cache &cache, int epollFd, Connection &conn)
+{
+    while (true)
+    {
+        // 缓冲区尾部没有空间了：先把未处理的数据挪到开头，还不够就扩容
+        if (conn.inEnd == conn.in.size())
+        {
+            if (conn.inStart > 0)
+            {
+                memmove(conn.in.data(), conn.in.data() + conn.inStart, conn.inEnd - conn.inStart);
+                conn.inEnd -= conn.inStart;
+                conn.inStart = 0;
+            }
+            else
+            {
+                conn.in.resize(conn.in.size() * 2);
+            }
+        }
+        ssize_t n = read(conn.fd, conn.in.data() + conn.inEnd, conn.in.size() - conn.inEnd);
+        if (n == 0)
+            return false; // 对端关闭
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        conn.inEnd += n;
+
+        // 解析所有完整的请求
+        while (true)
+        {
+            KCacheHeader header;
+            KFrameResult frame = nextFrame(conn.in.data() + conn.inStart, conn.inEnd - conn.inStart, header);
+            if (frame == KFrameError)
+                return false;
+            if (frame == KFrameIncomplete)
+                break; // 请求还没收全
+            if (!handleRequest(cache, conn, header, conn.in.data() + conn.inStart + KHeaderSize))
+                return false;
+            conn.inStart += KHeaderSize + header.bodyLen;
+        }
+        if (conn.inStart == conn.inEnd)
+            conn.inStart = conn.inEnd = 0;
+    }
+    return flushResponses(epollFd, conn);
+}
+
+static void closeConnection(int epollFd, Connection *conn)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    delete conn;
+}
+
+// 一个工作线程：一个epoll循环
+static void workerLoop(Cache &cache, int listenFd, bool exclusive)
+{
+    int epollFd = epoll_create1(0);
+    epoll_event ev{};
+    ev.events = EPOLLIN | (exclusive ? static_cast<uint32_t>(EPOLLEXCLUSIVE) : 0u);
+    ev.data.ptr = nullptr; // nullptr表示监听socket
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+
+    vector<epoll_event> events(256);
+    vector<Connection *> connections;
+    while (!g_stop)
+    {
+        int n = epoll_wait(epollFd, events.data(), events.size(), 200);
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.ptr == nullptr)
+            {
+                // 接受所有新连接
+                while (true)
+                {
+                    int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0)
+                        break;
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Unix域套接字上会失败，忽略即可
+                    Connection *conn = new Connection(fd);
+                    epoll_event connEv{};
+                    connEv.events = EPOLLIN;
+                    connEv.data.ptr = conn;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &connEv);
+                    connections.push_back(conn);
+                }
+                continue;
+            }
+            Connection *conn = static_cast<Connection *>(events[i].data.ptr);
+            bool ok = true;
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                ok = false;
+            if (ok && (events[i].events & EPOLLOUT))
+                ok = writePending(epollFd, *conn);
+            if (ok && (events[i].events & EPOLLIN))
+                ok = readRequests(cache, epollFd, *conn);
+            if (!ok)
+            {
+                for (auto &c : connections)
+                {
+                    if (c == conn)
+                    {
+                        c = connections.back();
+                        connections.pop_back();
+                        break;
+                    }
+                }
+                closeConnection(epollFd, conn);
+            }
+        }
+    }
+    for (auto conn : connections)
+        closeConnection(epollFd, conn);
+    close(epollFd);
+}
+
+static int listenTcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)); // 每个线程一个监听socket，内核负责分配连接
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 只监听本机
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 1024) < 0)
+    {
+        perror("listen tcp");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenUnix(const string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 1024) < 0)
+    {
+        perror("listen unix");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void onSignal(int)
+{
+    g_stop = true;
+}
+
+int main(int argc, char *argv[])
+{
+    string unixPath;
+    int port = 0;
+    int threadNum = std::thread::hardware_concurrency();
+    size_t capacity = 1 << 20;
+    int sliceNum = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string opt = argv[i];
+        if (opt == "--unix")
+            unixPath = argv[i + 1];
+        else if (opt == "--port")
+            port = atoi(argv[i + 1]);
+        else if (opt == "--threads")
+            threadNum = atoi(argv[i + 1]);
+        else if (opt == "--capacity")
+            capacity = strtoull(argv[i + 1], nullptr, 10);
+        else if (opt == "--slices")
+            sliceNum = atoi(argv[i + 1]);
+    }
+    if (unixPath.empty() && port <= 0)
+    {
+        cerr << "usage: percache-server (--port N | --unix PATH) [--threads N] [--capacity N] [--slices N]" << endl;
+        return 1;
+    }
+    threadNum = threadNum > 0 ? threadNum : 1;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    Cache cache(capacity, sliceNum);
+    vector<int> listenFds;
+    if (!unixPath.empty())
+    {
+        int fd = listenUnix(unixPath);
+        if (fd < 0)
+            return 1;
+        listenFds.push_back(fd);
+    }
+    else
+    {
+        for (int i = 0; i < threadNum; i++)
+        {
+            int fd = listenTcp(port);
+            if (fd < 0)
+                return 1;
+            listenFds.push_back(fd);
+        }
+    }
+
+    vector<thread> workers;
+    for (int i = 0; i < threadNum; i++)
+    {
+        bool shared = listenFds.size() == 1;
+        int listenFd = shared ? listenFds[0] : listenFds[i];
+        workers.emplace_back([&cache, listenFd, shared]()
+                             { workerLoop(cache, listenFd, shared); });
+    }
+    cout << "percache-server listening on " << (unixPath.empty() ? "127.0.0.1:" + to_string(port) : unixPath)
+         << " with " << threadNum << " threads" << endl;
+
+    for (auto &worker : workers)
+        worker.join();
+    for (int fd : listenFds)
+        close(fd);
+    if (!unixPath.empty())
+        unlink(unixPath.c_str());
+    return 0;
+}
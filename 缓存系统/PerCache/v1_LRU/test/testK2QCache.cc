@@ -0,0 +1,147 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include "K2QCache.h"
+#include "KLruCache.h"
+#include "KSlruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 热点数据 + 一次性扫描混合的访问序列：未命中时put，返回命中率
+/*
+    每次访问以scanPercent%的概率读一个从未出现过的key（扫描），否则从hotKeys个热点key中均匀地选一个。
+*/
+template <typename Cache>
+double hitRate(Cache &cache, int hotKeys, int scanPercent, int ops)
+{
+    unsigned seed = 11;
+    int hits = 0, value = 0, scanKey = 1000000;
+    for (int i = 0; i < ops; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = static_cast<int>((seed >> 8) % 100) < scanPercent ? scanKey++ : static_cast<int>((seed >> 12) % hotKeys);
+        if (cache.get(key, value))
+            hits++;
+        else
+            cache.put(key, key);
+    }
+    return static_cast<double>(hits) / ops;
+}
+
+// 对已经缓存的keys个key做ops次命中的get，返回每次get的纳秒数（重复3次取最好的一次）
+template <typename Cache>
+double hitNanos(Cache &cache, int keys, int ops)
+{
+    double best = 1e18;
+    for (int round = 0; round < 3; round++)
+    {
+        unsigned seed = 3;
+        int value = 0;
+        long long sum = 0;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < ops; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            cache.get(static_cast<int>((seed >> 8) % keys), value);
+            sum += value;
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+        if (sum < 0)
+            cout << sum; // 防止循环被优化掉
+        best = min(best, ns);
+    }
+    return best;
+}
+
+int main()
+{
+    // 测试1：容量8，A1in参考容量2，A1out记住4个key
+    K2QCache<int, string> cache(8);
+    for (int i = 1; i <= 8; i++)
+        cache.put(i, "V" + to_string(i));
+    cout << "A1in: " << cache.inSize() << ", Am: " << cache.mainSize() << ", A1out: " << cache.ghostSize() << endl; // 应输出 8, 0, 0
+
+    // 测试2：A1in中的key命中后不移动，仍然按进入的顺序淘汰到A1out
+    string value;
+    cache.get(1, value);
+    cache.put(9, "V9");
+    cache.put(10, "V10");
+    cout << "Key 1 evicted to A1out despite hit: " << (cache.get(1, value) ? "No" : "Yes")
+         << ", A1out: " << cache.ghostSize() << endl; // 应输出 Yes, A1out: 2
+
+    // 测试3：A1out中的key再次put时直接进入Am
+    cache.put(1, "One again");
+    cout << "A1in: " << cache.inSize() << ", Am: " << cache.mainSize() << ", A1out: " << cache.ghostSize()
+         << ", key 1: " << cache.get(1) << endl; // 应输出 7, 1, 2, One again
+
+    // 测试4：A1out只记住最近的4个key
+    for (int i = 11; i <= 20; i++)
+        cache.put(i, "V" + to_string(i));
+    cout << "A1out: " << cache.ghostSize() << ", key 2 forgotten: " << (cache.get(2, value) ? "No" : "Yes") << endl;
+    cache.put(2, "Two");
+    cout << "Forgotten key 2 goes back to A1in: Am " << cache.mainSize() << endl; // 应输出 Am 1
+
+    // 测试5：更新和删除（A1in中的key删除后队列里的项惰性丢弃）
+    cache.put(1, "One updated");
+    cout << "Key 1 updated: " << cache.get(1) << endl;
+    cache.remove(1);
+    cache.remove(20);
+    cout << "Keys 1, 20 removed: " << (!cache.get(1, value) && !cache.get(20, value) ? "Yes" : "No") << ", size: " << cache.size() << endl;
+    cache.put(20, "V20 again");
+    for (int i = 21; i <= 40; i++)
+        cache.put(i, "V" + to_string(i));
+    cout << "Size after more puts: " << cache.size() << " (capacity 8)" << endl;
+
+    // 测试6：热点数据 + 扫描时的命中率（容量1000，热点700个key，一半的访问是一次性扫描）
+    const int capacity = 1000, hotKeys = 700, scanPercent = 50, ops = 500000;
+    K2QCache<int, int> twoQ(capacity);
+    KLruCache<int, int> lru(capacity);
+    KLruKCache<int, int> lruK(capacity, 2 * capacity, 3); // 未命中时的get和put各计一次访问，k=2时和LRU完全一样
+    KSlruCache<int, int> slru(capacity);
+    cout << "Hit rate with scans: 2Q " << hitRate(twoQ, hotKeys, scanPercent, ops)
+         << ", LRU " << hitRate(lru, hotKeys, scanPercent, ops)
+         << ", LRU-3 " << hitRate(lruK, hotKeys, scanPercent, ops)
+         << ", SLRU " << hitRate(slru, hotKeys, scanPercent, ops)
+         << " (best possible " << (100 - scanPercent) / 100.0 << ")" << endl;
+
+    // 测试7：每次命中的耗时：A1in命中不动链表，Am命中和KLruCache/KLruKCache一样要移动链表节点
+    const int keys = 1000, gets = 2000000;
+    K2QCache<int, int> inHits(2 * keys);
+    for (int i = 0; i < keys; i++)
+        inHits.put(i, i);
+    K2QCache<int, int> mainHits(2 * keys);
+    for (int i = 0; i < keys; i++)
+        mainHits.put(i, i);
+    for (int i = keys; i < 3 * keys; i++)
+        mainHits.put(i, i); // 把0 ~ keys-1挤到A1out
+    for (int i = 0; i < keys; i++)
+        mainHits.put(i, i); // 再次put，进入Am
+    KLruCache<int, int> lruHits(2 * keys);
+    KLruKCache<int, int> lruKHits(2 * keys, 2 * keys, 2);
+    for (int i = 0; i < keys; i++)
+    {
+        lruHits.put(i, i);
+        lruKHits.put(i, i);
+        lruKHits.get(i); // 第2次访问，进入主缓存
+    }
+    cout << "Keys in Am: " << mainHits.mainSize() << ", keys in A1in: " << inHits.inSize() << endl;
+    cout << "ns per hit: 2Q A1in " << hitNanos(inHits, keys, gets) << ", 2Q Am " << hitNanos(mainHits, keys, gets)
+         << ", LRU " << hitNanos(lruHits, keys, gets) << ", LRU-2 " << hitNanos(lruKHits, keys, gets) << endl;
+    return 0;
+}
+
+/*测试结果（单核机器，未开优化的构建；纳秒数只用来比较相对大小）
+A1in: 8, Am: 0, A1out: 0
+Key 1 evicted to A1out despite hit: Yes, A1out: 2
+A1in: 7, Am: 1, A1out: 2, key 1: One again
+A1out: 4, key 2 forgotten: Yes
+Forgotten key 2 goes back to A1in: Am 1
+Key 1 updated: One updated
+Keys 1, 20 removed: Yes, size: 6
+Size after more puts: 8 (capacity 8)
+Hit rate with scans: 2Q 0.498222, LRU 0.401916, LRU-3 0.500018, SLRU 0.499516 (best possible 0.5)
+Keys in Am: 1000, keys in A1in: 1000
+ns per hit: 2Q A1in 144.499, 2Q Am 545.034, LRU 555.688, LRU-2 611.953
+*/
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <malloc.h> //mallinfo2：统计堆内存
+#include "KApproxLruCache.h"
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 当前堆上已分配的字节数
+size_t heapBytes()
+{
+    return mallinfo2().uordblks + mallinfo2().hblkhd;
+}
+
+// 偏斜的访问序列：未命中时put，返回命中率
+template <typename Cache>
+double hitRate(Cache &cache, int keys, int ops)
+{
+    unsigned seed = 7;
+    int hits = 0, value = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        double r = ((seed >> 8) % 1000000) / 1000000.0;
+        int key = static_cast<int>(r * r * keys);
+        if (cache.get(key, value))
+            hits++;
+        else
+            cache.put(key, key);
+    }
+    return static_cast<double>(hits) / ops;
+}
+
+int main()
+{
+    // 测试1：基本功能
+    KApproxLruCache<string, string> cache(3);
+    cache.put("a", "1");
+    cache.put("b", "2");
+    cache.put("c", "3");
+    cache.put("a", "10"); // 更新
+    cout << "Key a: " << cache.get("a") << endl; // 应输出 10
+    cache.remove("b");
+    cout << "Key b removed: " << (cache.get("b").empty() ? "Yes" : "No") << ", size: " << cache.size() << endl; // 应输出 Yes, size: 2
+    cache.put("d", "4");
+    cache.put("e", "5"); // 满了，淘汰一个
+    cout << "Size after overflow: " << cache.size() << endl; // 应输出 3
+
+    // 测试2：元素很少、采样数较多时，几乎总能采到最久未访问的元素
+    KApproxLruCache<int, int> exact(3, 8);
+    exact.put(1, 1);
+    exact.put(2, 2);
+    exact.put(3, 3);
+    exact.get(1);
+    exact.put(4, 4); // 最久未访问的是2
+    cout << "Key 2 evicted: " << (exact.get(2) == 0 ? "Yes" : "No") << ", key 1 kept: " << (exact.get(1) == 1 ? "Yes" : "No") << endl;
+
+    // 测试3：时钟回绕：key 0插入后再也没有访问，key 1在2^24次put之前的100次put时访问过
+    /*
+        容量3时时钟每次put加1，2^24次put之后时钟回绕。没有年龄饱和时key 0的年龄（模2^24）只有几格，
+        看起来比key 1还新，淘汰的会是key 1；年龄饱和以后key 0的年龄停在2^23，淘汰的是key 0。
+    */
+    KApproxLruCache<int, int> wrap(3, 16, 0);
+    wrap.put(0, 0);
+    wrap.put(1, 1);
+    wrap.put(2, 2);
+    const int wrapPuts = (1 << 24) + 10;
+    for (int i = 3; i < wrapPuts; i++)
+        wrap.put(i == (1 << 24) - 100 ? 1 : 2, i); // 其余的put都是更新key 2，推进时钟
+    wrap.put(3, 3);
+    cout << "After " << wrapPuts << " puts: untouched key 0 evicted: " << (wrap.get(0) == 0 ? "Yes" : "No")
+         << ", recently touched key 1 kept: " << (wrap.get(1) != 0 ? "Yes" : "No") << endl; // 应输出 Yes, Yes
+
+    // 测试4：命中率和精确LRU比较
+    const int keys = 100000, capacity = 10000, ops = 1000000;
+    KLruCache<int, int> lru(capacity);
+    KApproxLruCache<int, int> noPool(capacity, 5, 0);
+    KApproxLruCache<int, int> withPool(capacity, 5, 16);
+    KApproxLruCache<int, int> tenSamples(capacity, 10, 16);
+    cout << "Hit rate exact LRU:             " << hitRate(lru, keys, ops) << endl;
+    cout << "Hit rate sampled (5, no pool):  " << hitRate(noPool, keys, ops) << endl;
+    cout << "Hit rate sampled (5, pool 16):  " << hitRate(withPool, keys, ops) << endl;
+    cout << "Hit rate sampled (10, pool 16): " << hitRate(tenSamples, keys, ops) << endl;
+
+    // 测试5：每个元素的内存开销（int -> int，100万个元素）
+    const int entries = 1000000;
+    size_t before = heapBytes();
+    {
+        KLruCache<int, int> big(entries);
+        for (int i = 0; i < entries; i++)
+            big.put(i, i);
+        cout << "KLruCache bytes per entry:       " << (heapBytes() - before) / static_cast<double>(entries) << endl;
+    }
+    before = heapBytes();
+    {
+        KApproxLruCache<int, int> big(entries);
+        for (int i = 0; i < entries; i++)
+            big.put(i, i);
+        cout << "KApproxLruCache bytes per entry: " << (heapBytes() - before) / static_cast<double>(entries)
+             << " (slot " << KApproxLruCache<int, int>::slotBytes() << " bytes, " << big.tableSize() << " slots)" << endl;
+
+        // 测试6：get的耗时
+        auto start = chrono::steady_clock::now();
+        long long sum = 0;
+        int value = 0;
+        for (int i = 0; i < entries; i++)
+        {
+            big.get(static_cast<int>((i * 7919LL) % entries), value);
+            sum += value;
+        }
+        double approxNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / entries;
+        cout << "KApproxLruCache get: " << approxNs << " ns (checksum " << sum << ")" << endl;
+    }
+    return 0;
+}
+
+/*测试结果（bytes per entry包括数组中空着的槽位；KLruCache包括LruNode、shared_ptr控制块和unordered_map的节点）
+Key a: 10
+Key b removed: Yes, size: 2
+Size after overflow: 3
+Key 2 evicted: Yes, key 1 kept: Yes
+After 16777226 puts: untouched key 0 evicted: Yes, recently touched key 1 kept: Yes
+Hit rate exact LRU:             0.189611
+Hit rate sampled (5, no pool):  0.187896
+Hit rate sampled (5, pool 16):  0.188793
+Hit rate sampled (10, pool 16): 0.189578
+KLruCache bytes per entry:       184.393
+KApproxLruCache bytes per entry: 33.5548 (slot 16 bytes, 2097152 slots)
+KApproxLruCache get: 185.334 ns (checksum 499999500000)
+*/
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "KAsyncCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+KExecutor executor(2); // 2个工作线程
+
+// 模拟异步I/O的加载函数：挂起50毫秒（不占用线程），返回"loaded-key"
+KTask<string> slowLoader(const int &key)
+{
+    int k = key; // 挂起之后引用参数可能已经失效，先拷贝
+    co_await executor.sleepFor(chrono::milliseconds(50));
+    co_return "loaded-" + to_string(k);
+}
+
+atomic<int> finished{0};
+atomic<int> correct{0};
+
+// 一个请求：切换到执行器线程，然后co_getOrLoad
+KTask<void> request(KAsyncLoadingCache<int, string> &cache, int key)
+{
+    co_await executor.schedule();
+    string value = co_await cache.co_getOrLoad(key, slowLoader);
+    if (value == "loaded-" + to_string(key))
+        correct++;
+    finished++;
+}
+
+void waitFinished(int expected)
+{
+    while (finished < expected)
+        this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+int main()
+{
+    // 测试1：co_get / co_put
+    KAsyncLoadingCache<int, string> cache(1000, 4, executor);
+    optional<string> missing = syncWait(cache.co_get(1));
+    cout << "co_get before put: " << (missing ? *missing : "miss") << endl; // 应输出 miss
+    syncWait(cache.co_put(1, "one"));
+    cout << "co_get after put: " << syncWait(cache.co_get(1)).value_or("miss") << endl; // 应输出 one
+
+    // 测试2：同一个key的100个并发请求只加载一次，加载完成后一起恢复
+    for (int i = 0; i < 100; i++)
+        spawn(request(cache, 7));
+    waitFinished(100);
+    cout << "100 waiters on key 7: " << correct << " correct, loader called " << cache.loadCount() << " time(s)" << endl;
+
+    // 测试3：加载期间不占用线程：2个工作线程上同时进行200个不同key的加载（每个50毫秒）
+    finished = 0;
+    correct = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 1000; i < 1200; i++)
+        spawn(request(cache, i));
+    waitFinished(200);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "200 concurrent loads on 2 threads: " << correct << " correct, " << ms << " ms, "
+         << (ms < 1000 ? "overlapped (as expected)" : "serialized") << endl; // 阻塞式加载需要 200 * 50 / 2 = 5000毫秒
+
+    // 测试4：命中缓存时不再调用loader
+    uint64_t loadsBefore = cache.loadCount();
+    cout << "Key 1100 again: " << syncWait(cache.co_getOrLoad(1100, slowLoader))
+         << ", extra loads: " << cache.loadCount() - loadsBefore << endl; // 应输出 loaded-1100, extra loads: 0
+
+    // 测试5：loader抛出异常时每个等待者都收到异常，不缓存结果，下一次重新加载
+    atomic<int> failures{0};
+    KAsyncLoadingCache<int, string>::Loader failing = [](const int &) -> KTask<string>
+    {
+        co_await executor.sleepFor(chrono::milliseconds(20));
+        throw runtime_error("backend down");
+    };
+    auto failingRequest = [&](int) -> KTask<void>
+    {
+        co_await executor.schedule();
+        try
+        {
+            co_await cache.co_getOrLoad(42, failing);
+        }
+        catch (const runtime_error &)
+        {
+            failures++;
+        }
+        finished++;
+    };
+    finished = 0;
+    for (int i = 0; i < 10; i++)
+        spawn(failingRequest(i));
+    waitFinished(10);
+    cout << "Failed loads seen by waiters: " << failures << endl; // 应输出 10
+    cout << "Key 42 after failure: " << syncWait(cache.co_getOrLoad(42, slowLoader)) << endl; // 应输出 loaded-42
+
+    // 测试6：分片锁的竞争：1个分片，1000个协程同时co_put，锁被占用时挂起等待
+    KAsyncLoadingCache<int, int> contended(10000, 1, executor);
+    auto writer = [&](int i) -> KTask<void>
+    {
+        co_await executor.schedule();
+        co_await contended.co_put(i, i * 2);
+        finished++;
+    };
+    finished = 0;
+    for (int i = 0; i < 1000; i++)
+        spawn(writer(i));
+    waitFinished(1000);
+    cout << "Contended puts, key 999: " << syncWait(contended.co_get(999)).value_or(-1) << endl; // 应输出 1998
+    return 0;
+}
+
+/*测试结果
+co_get before put: miss
+co_get after put: one
+100 waiters on key 7: 100 correct, loader called 1 time(s)
+200 concurrent loads on 2 threads: 200 correct, 51.5045 ms, overlapped (as expected)
+Key 1100 again: loaded-1100, extra loads: 0
+Failed loads seen by waiters: 10
+Key 42 after failure: loaded-42
+Contended puts, key 999: 1998
+*/
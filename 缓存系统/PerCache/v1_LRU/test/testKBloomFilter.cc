@@ -0,0 +1,73 @@
+#include <iostream>
+#include <string>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：布隆过滤器没有漏判，误判率接近目标
+    KBloomFilter<int> filter(10000, 0.01);
+    for (int i = 0; i < 10000; i++)
+        filter.add(i);
+    int missing = 0;
+    for (int i = 0; i < 10000; i++)
+        missing += filter.contains(i) ? 0 : 1;
+    int falsePositive = 0;
+    for (int i = 100000; i < 200000; i++)
+        falsePositive += filter.contains(i) ? 1 : 0;
+    cout << "False negatives: " << missing << endl;                                 // 应输出 0
+    cout << "False positive rate below 3%: " << (falsePositive < 3000 ? "Yes" : "No") << endl; // 应输出 Yes
+
+    // 测试2：轮换两次以后，旧的key被忘掉
+    filter.rotate();
+    cout << "Key 1 after one rotation: " << (filter.contains(1) ? "remembered" : "forgotten") << endl;  // 应输出 remembered
+    filter.rotate();
+    cout << "Key 1 after two rotations: " << (filter.contains(1) ? "remembered" : "forgotten") << endl; // 应输出 forgotten
+
+    // 测试3：KLruKCache开启门卫后，一次性的key不占用历史缓存
+    // 两个缓存做完全相同的操作（k=3，历史缓存只记3个key），只有第一个开启门卫：
+    // put两次key 1，put扫描100个只出现一次的key，再put两次key 1
+    KLruKCache<int, int> cache(2, 3, 3);
+    KLruKCache<int, int> plain(2, 3, 3);
+    cache.enableDoorkeeper(1000);
+    for (KLruKCache<int, int> *c : {&cache, &plain})
+    {
+        c->put(1, 100);
+        c->put(1, 100); // 门卫：第一次只记录在门卫中，这次计数1；不开门卫：计数2
+        for (int i = 1000; i < 1100; i++)
+            c->put(i, i); // 门卫拦下它们；不开门卫时它们进历史缓存，把key 1的计数挤掉
+        c->put(1, 100);
+        c->put(1, 100); // 门卫：计数3，进入主缓存；不开门卫：计数重新从1开始，只到2
+    }
+    // 用基类的get只查主缓存（KLruKCache::get本身会增加历史计数）
+    int value = 0;
+    bool promoted = cache.KLruCache<int, int>::get(1, value);
+    cout << "Key 1 after scan with doorkeeper: " << (promoted ? to_string(value) : "not in main cache") << endl; // 应输出 100（不开门卫时是not in main cache）
+    promoted = plain.KLruCache<int, int>::get(1, value);
+    cout << "Key 1 after scan without doorkeeper: " << (promoted ? to_string(value) : "not in main cache") << endl; // 应输出 not in main cache
+
+    // 测试4：负缓存，记录后端存储中不存在的key
+    cache.enableNegativeCache(1000);
+    cache.markAbsent(404);
+    cout << "Key 404 known absent: " << (cache.isKnownAbsent(404) ? "Yes" : "No") << endl; // 应输出 Yes
+    cout << "Key 1 known absent: " << (cache.isKnownAbsent(1) ? "Yes" : "No") << endl;     // 应输出 No
+    cache.rotateNegativeCache();
+    cache.rotateNegativeCache();
+    cout << "Key 404 after rotations: " << (cache.isKnownAbsent(404) ? "Yes" : "No") << endl; // 应输出 No
+
+    return 0;
+}
+
+/*测试结果
+False negatives: 0
+False positive rate below 3%: Yes
+Key 1 after one rotation: remembered
+Key 1 after two rotations: forgotten
+Key 1 after scan with doorkeeper: 100
+Key 1 after scan without doorkeeper: not in main cache
+Key 404 known absent: Yes
+Key 1 known absent: No
+Key 404 after rotations: No
+*/
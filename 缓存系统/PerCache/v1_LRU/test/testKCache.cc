@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include "KCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：单线程LRU（扁平索引 + 不加锁），没有虚函数也没有同步开销
+    KCache<int, string, KLruEviction, KFlatIndex, KNoLock> lru(2);
+    lru.put(1, "One");
+    lru.put(2, "Two");
+    string value;
+    lru.get(1, value);     // 访问1，2变成最久未使用
+    lru.put(3, "Three");   // 淘汰2
+    cout << "LRU key 2 " << (lru.get(2, value) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "LRU key 1: " << lru.get(1) << endl; // 应输出 One
+    cout << "LRU key 3: " << lru.get(3) << endl; // 应输出 Three
+
+    // 测试2：LRU-K（k=2），第一次put不进入缓存，第二次put才进入
+    KCache<int, int, KLruKEviction, KNodeIndex, KNoLock> lruK(2, 10, 2);
+    int iv = 0;
+    lruK.put(1, 100);
+    cout << "LRU-K key 1 after one put: " << (lruK.get(1, iv) ? "cached" : "not cached (as expected)") << endl;
+    lruK.put(1, 100); // get未命中也算一次访问，这里满足k次
+    cout << "LRU-K key 1 after second access: " << lruK.get(1) << endl; // 应输出 100
+
+    // 测试3：LFU，淘汰访问频次最低的元素
+    KCache<int, int, KLfuEviction, KFlatIndex, KNoLock> lfu(2);
+    lfu.put(1, 10);
+    lfu.put(2, 20);
+    lfu.get(1);
+    lfu.get(1);
+    lfu.get(2);
+    lfu.put(3, 30); // key2频次为2，key1频次为3，淘汰key2
+    cout << "LFU key 2 " << (lfu.get(2, iv) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "LFU key 1: " << lfu.get(1) << endl; // 应输出 10
+
+    // 测试4：remove后slot被复用
+    lfu.remove(1);
+    lfu.put(4, 40);
+    cout << "LFU size after remove and put: " << lfu.size() << endl; // 应输出 2
+
+    // 测试5：通过KICachePolicy接口使用（适配器）
+    unique_ptr<KICachePolicy<int, string>> policy(new KCacheAdapter<int, string>(2));
+    policy->put(1, "Apple");
+    policy->put(2, "Banana");
+    cout << "Adapter key 2: " << policy->get(2) << endl; // 应输出 Banana
+
+    // 测试6：自旋锁版本多线程并发put/get
+    KCache<int, int, KLruEviction, KFlatIndex, KSpinLock> shared(1000);
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&shared, t]()
+                             {
+            for (int i = 0; i < 10000; i++)
+            {
+                shared.put(i % 2000, t);
+                shared.get((i * 7) % 2000);
+            } });
+    }
+    for (auto &th : threads)
+        th.join();
+    cout << "Spinlock cache size: " << shared.size() << endl; // 应输出 1000
+
+    return 0;
+}
+
+/*测试结果
+LRU key 2 was evicted (as expected)
+LRU key 1: One
+LRU key 3: Three
+LRU-K key 1 after one put: not cached (as expected)
+LRU-K key 1 after second access: 100
+LFU key 2 was evicted (as expected)
+LFU key 1: 10
+LFU size after remove and put: 2
+Adapter key 2: Banana
+Spinlock cache size: 1000
+*/
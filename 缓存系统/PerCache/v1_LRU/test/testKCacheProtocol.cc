@@ -0,0 +1,116 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "KCacheProtocol.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 像服务器一样切帧：从buffer中切出所有完整的请求，每个请求的字段拼成"op:field1,field2"追加到out，返回消耗的字节数
+// 遇到协议错误时把"error"追加到out
+size_t parseAll(const string &buffer, vector<string> &out)
+{
+    size_t start = 0;
+    while (true)
+    {
+        KCacheHeader header;
+        KFrameResult frame = nextFrame(buffer.data() + start, buffer.size() - start, header);
+        if (frame == KFrameIncomplete)
+            break;
+        if (frame == KFrameError)
+        {
+            out.push_back("error");
+            break;
+        }
+        KFieldReader reader{buffer.data() + start + KHeaderSize, header.bodyLen};
+        string request = to_string(header.code) + ":";
+        const char *data;
+        uint32_t len;
+        for (uint16_t i = 0; i < header.count; i++)
+        {
+            if (!reader.next(data, len))
+            {
+                request = "error";
+                break;
+            }
+            request += (i > 0 ? "," : "") + string(data, len);
+        }
+        out.push_back(request);
+        start += KHeaderSize + header.bodyLen;
+    }
+    return start;
+}
+
+int main()
+{
+    // 流水线：一个缓冲区里连续放三个请求
+    string pipeline;
+    string getFields[] = {"user:1"};
+    string setFields[] = {"user:2", "Alice"};
+    string mgetFields[] = {"a", "", "ccc"};
+    encodeRequest(pipeline, KOpGet, getFields, 1);
+    encodeRequest(pipeline, KOpSet, setFields, 2);
+    encodeRequest(pipeline, KOpMGet, mgetFields, 3);
+
+    // 测试1：一次收到全部数据
+    vector<string> requests;
+    size_t used = parseAll(pipeline, requests);
+    cout << "Pipelined requests: " << requests.size() << ", consumed all bytes: " << (used == pipeline.size() ? "Yes" : "No") << endl;
+    for (auto &request : requests)
+        cout << "  " << request << endl; // 应输出 1:user:1  2:user:2,Alice  4:a,,ccc
+
+    // 测试2：每次只多收到一个字节（请求头、字段长度、数据都可能被截断），结果和一次收全相同
+    string received;
+    vector<string> byteByByte;
+    size_t consumed = 0;
+    int incompleteCalls = 0;
+    for (char c : pipeline)
+    {
+        received.push_back(c);
+        size_t before = byteByByte.size();
+        consumed += parseAll(received.substr(consumed), byteByByte);
+        if (byteByByte.size() == before)
+            incompleteCalls++;
+    }
+    cout << "Byte-by-byte: " << byteByByte.size() << " requests, same as whole buffer: " << (byteByByte == requests ? "Yes" : "No")
+         << ", partial reads: " << incompleteCalls << " of " << pipeline.size() << endl;
+
+    // 测试3：在任意位置切成两半，前一半中完整的请求先被处理，剩下的等后一半
+    bool allSplitsMatch = true;
+    for (size_t cut = 0; cut <= pipeline.size(); cut++)
+    {
+        vector<string> parsed;
+        size_t first = parseAll(pipeline.substr(0, cut), parsed);
+        parseAll(pipeline.substr(first), parsed);
+        allSplitsMatch = allSplitsMatch && parsed == requests;
+    }
+    cout << "Every split point gives the same requests: " << (allSplitsMatch ? "Yes" : "No") << endl;
+
+    // 测试4：请求体长度超过上限，只看请求头就报错（不等请求体）
+    char header[KHeaderSize];
+    encodeHeader(header, KOpGet, 1, static_cast<uint32_t>(KMaxBodySize + 1));
+    vector<string> oversized;
+    parseAll(string(header, KHeaderSize), oversized);
+    cout << "Oversized body: " << (oversized.size() == 1 ? oversized[0] : "not detected") << endl; // 应输出 error
+
+    // 测试5：字段长度超出请求体，KFieldReader报错
+    string bad;
+    encodeRequest(bad, KOpGet, getFields, 1);
+    uint32_t hugeLen = 1000;
+    bad.replace(KHeaderSize, sizeof(hugeLen), reinterpret_cast<const char *>(&hugeLen), sizeof(hugeLen));
+    vector<string> malformed;
+    parseAll(bad, malformed);
+    cout << "Field longer than body: " << (malformed.size() == 1 ? malformed[0] : "not detected") << endl; // 应输出 error
+    return 0;
+}
+
+/*测试结果
+Pipelined requests: 3, consumed all bytes: Yes
+  1:user:1
+  2:user:2,Alice
+  4:a,,ccc
+Byte-by-byte: 3 requests, same as whole buffer: Yes, partial reads: 66 of 69
+Every split point gives the same requests: Yes
+Oversized body: error
+Field longer than body: error
+*/
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 往缓存中写入大value（每个1MB），返回put耗时的p999和最大值（微秒）
+template <typename Cache>
+pair<double, double> putLatency(Cache &cache, int count)
+{
+    vector<double> latencies;
+    string big(1 << 20, 'x');
+    for (int i = 0; i < count; i++)
+    {
+        string value = big; // 在计时外准备好value
+        auto start = chrono::steady_clock::now();
+        cache.put(i, move(value));
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    sort(latencies.begin(), latencies.end());
+    return make_pair(latencies[latencies.size() * 999 / 1000], latencies.back());
+}
+
+int main()
+{
+    // 测试1：软超额——元素个数最多超出容量softOvershoot个，然后一次淘汰一批
+    KLruCache<int, int> cache(10);
+    cache.enableDeferredEviction(4, false); // 不使用后台线程，在调用者线程中锁外析构
+    for (int i = 0; i < 14; i++)
+        cache.put(i, i);
+    cout << "Size with overshoot: " << cache.size() << endl; // 应输出 14
+    cache.put(14, 14);                                       // 超过容量+4，一次淘汰5个
+    cout << "Size after batch eviction: " << cache.size() << endl; // 应输出 10
+    int value = 0;
+    cout << "Key 4 " << (cache.get(4, value) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "Key 5 " << (cache.get(5, value) ? "exists (as expected)" : "was evicted") << endl;
+
+    // 测试2：后台回收线程析构被淘汰的大value
+    KLruCache<int, string> inlineCache(64);
+    KLruCache<int, string> deferredCache(64);
+    deferredCache.enableDeferredEviction(8, true);
+    pair<double, double> inlineLatency = putLatency(inlineCache, 2000);
+    pair<double, double> deferredLatency = putLatency(deferredCache, 2000);
+    KReclaimer::shared().drain();
+    cout << "Deferred cache size: " << deferredCache.size() << endl; // 应输出 64~72之间
+    cout << "inline eviction   put p999/max (us): " << inlineLatency.first << " / " << inlineLatency.second << endl;
+    cout << "deferred eviction put p999/max (us): " << deferredLatency.first << " / " << deferredLatency.second << endl;
+
+    // 测试3：分片缓存开启延迟淘汰，重新分片后的新分片同样生效
+    KHashLruCaches<int, string> sharded(100, 4);
+    sharded.enableDeferredEviction(4);
+    sharded.reshard(2);
+    sharded.waitForReshard();
+    for (int i = 0; i < 1000; i++)
+        sharded.put(i, "Value" + to_string(i));
+    cout << "Sharded size within soft limit: " << (sharded.size() <= 100 + 2 * 4 ? "Yes" : "No") << endl; // 应输出 Yes
+
+    return 0;
+}
+
+/*测试结果（-O2编译，单核机器：回收线程和写入者抢同一个核心，耗时差别不明显；多核机器上延迟淘汰的长尾会明显降低）
+Size with overshoot: 14
+Size after batch eviction: 10
+Key 4 was evicted (as expected)
+Key 5 exists (as expected)
+Deferred cache size: 65
+inline eviction   put p999/max (us): 1925.63 / 3703.34
+deferred eviction put p999/max (us): 2314 / 2994.78
+Sharded size within soft limit: Yes
+*/
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "KFcLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 多个线程并发访问同一个缓存（同一个热点分片），返回每秒操作数
+template <typename Cache>
+double runThreads(Cache &cache, int threadNum, int opsPerThread)
+{
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < threadNum; t++)
+    {
+        threads.emplace_back([&cache, t, opsPerThread]()
+                             {
+            int value = 0;
+            for (int i = 0; i < opsPerThread; i++)
+            {
+                int key = (i * 31 + t) % 2000;
+                if (i % 4 == 0)
+                    cache.put(key, i);
+                else
+                    cache.get(key, value);
+            } });
+    }
+    for (auto &th : threads)
+        th.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return threadNum * opsPerThread / seconds;
+}
+
+int main()
+{
+    // 测试1：单线程语义和KLruCache一致
+    KFcLruCache<int, string> cache(2);
+    cache.put(1, "One");
+    cache.put(2, "Two");
+    string value;
+    cache.get(1, value);
+    cache.put(3, "Three"); // 淘汰2
+    cout << "Key 2 " << (cache.get(2, value) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "Key 1: " << cache.get(1) << endl; // 应输出 One
+    cache.remove(1);                          // 普通接口照常使用
+    cout << "Key 1 " << (cache.get(1, value) ? "exists" : "has been removed.") << endl;
+
+    // 测试2：多线程并发，所有请求都被正确执行
+    KFcLruCache<int, int> counter(100);
+    vector<thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&counter, t]()
+                             {
+            for (int i = 0; i < 1000; i++)
+                counter.put(t * 1000 + i, i); });
+    }
+    for (auto &th : threads)
+        th.join();
+    cout << "Size after concurrent puts: " << counter.size() << endl; // 应输出 100
+
+    // 测试3：热点分片上和普通KLruCache的吞吐对比
+    unsigned threadNum = std::thread::hardware_concurrency();
+    threadNum = threadNum < 4 ? 4 : threadNum;
+    KLruCache<int, int> plain(1000);
+    KFcLruCache<int, int> combining(1000);
+    cout << "Threads: " << threadNum << endl;
+    cout << "KLruCache   ops/s: " << runThreads(plain, threadNum, 100000) << endl;
+    cout << "KFcLruCache ops/s: " << runThreads(combining, threadNum, 100000) << endl;
+
+    return 0;
+}
+
+/*测试结果（吞吐与机器核数有关：下面是单核机器上的结果，等待者只能让出CPU，平坦合并没有优势；
+            核数越多、线程越多，平坦合并的优势越明显）
+Key 2 was evicted (as expected)
+Key 1: One
+Key 1 has been removed.
+Size after concurrent puts: 100
+Threads: 4
+KLruCache   ops/s: 1.9652e+06
+KFcLruCache ops/s: 365212
+*/
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：弱一致遍历，遍历期间修改缓存
+    KLruCache<int, int> cache(100);
+    for (int i = 0; i < 100; i++)
+        cache.put(i, i);
+    map<int, int> seen;
+    int duplicates = 0;
+    int value = 0;
+    cache.forEach([&](const int &key, const int &val)
+                  {
+                      if (seen.count(key))
+                          duplicates++;
+                      seen[key] = val;
+                      if (key == 10)
+                      {
+                          cache.get(20, value);  // 把还没遍历到的20移到链表尾部
+                          cache.put(30, 3000);   // 修改还没遍历到的30
+                          cache.remove(40);      // 删除还没遍历到的40
+                          cache.put(1000, 1000); // 遍历开始后插入的新元素（淘汰最久未使用的0）
+                      } },
+                  8);
+    cout << "Visited: " << seen.size() << ", duplicates: " << duplicates << endl;                  // 应输出 Visited: 99, duplicates: 0
+    cout << "Key 30 value: " << seen[30] << endl;                                                     // 应输出 3000（修改后的值）
+    cout << "Key 40 visited: " << (seen.count(40) ? "Yes" : "No") << endl;                           // 应输出 No
+    cout << "Key 1000 visited: " << (seen.count(1000) ? "Yes" : "No") << endl;                       // 应输出 No
+    cout << "Cache still works: " << (cache.get(1000, value) && value == 1000 ? "Yes" : "No") << endl; // 应输出 Yes
+
+    // 测试2：快照模式，遍历结果是开始时刻的内容
+    KLruCache<int, int> snapCache(100);
+    for (int i = 0; i < 100; i++)
+        snapCache.put(i, i);
+    map<int, int> snap;
+    snapCache.forEach([&](const int &key, const int &val)
+                      {
+                          snap[key] = val;
+                          if (key == 10)
+                          {
+                              snapCache.put(30, 3000);
+                              snapCache.remove(40);
+                              for (int i = 200; i < 250; i++) // 插入新元素，淘汰掉很多还没遍历到的元素
+                                  snapCache.put(i, i);
+                          } },
+                      8, true);
+    bool exact = snap.size() == 100;
+    for (int i = 0; i < 100; i++)
+        exact = exact && snap.count(i) && snap[i] == i;
+    cout << "Snapshot equals initial contents: " << (exact ? "Yes" : "No") << endl; // 应输出 Yes
+
+    // 测试3：分片缓存快照，并发写入时导出
+    KHashLruCaches<int, string> sharded(10000, 8);
+    for (int i = 0; i < 10000; i++)
+        sharded.put(i, "v" + to_string(i));
+    atomic<bool> stop(false);
+    thread writer([&]()
+                  {
+                      int i = 0;
+                      while (!stop)
+                      {
+                          sharded.put(i % 10000, "new");
+                          sharded.put(100000 + i, "x");
+                          i++;
+                      } });
+    vector<pair<int, string>> dump = sharded.snapshot(32);
+    stop = true;
+    writer.join();
+    bool consistent = dump.size() == 10000;
+    for (auto &entry : dump)
+        consistent = consistent && entry.first < 10000 && entry.second == "v" + to_string(entry.first);
+    cout << "Sharded snapshot size: " << dump.size() << ", consistent: " << (consistent ? "Yes" : "No") << endl; // 应输出 10000, Yes
+
+    // 测试4：遍历时请求的最大延迟（对比一次性持锁拷贝整个缓存）
+    KLruCache<int, string> big(200000);
+    for (int i = 0; i < 200000; i++)
+        big.put(i, string(64, 'x'));
+    atomic<bool> walking(true);
+    double maxLatency = 0;
+    thread reader([&]()
+                  {
+                      string val;
+                      int i = 0;
+                      while (walking)
+                      {
+                          auto start = chrono::steady_clock::now();
+                          big.get(i++ % 200000, val);
+                          maxLatency = max(maxLatency, chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+                      } });
+    size_t count = 0;
+    auto start = chrono::steady_clock::now();
+    big.forEach([&](const int &, const string &)
+                { count++; },
+                64, true);
+    double walkTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    walking = false;
+    reader.join();
+    cout << "Walked " << count << " entries in " << walkTime << " ms, max get latency during walk: " << maxLatency << " us" << endl;
+
+    // 测试5：fn抛出异常时遍历也会结束（游标移除、遍历锁释放），之后还能再遍历
+    KLruCache<int, int> throwing(10);
+    KHashLruCaches<int, int> throwingSharded(10, 2);
+    for (int i = 0; i < 10; i++)
+    {
+        throwing.put(i, i);
+        throwingSharded.put(i, i);
+    }
+    auto thrower = [](const int &key, const int &)
+    {
+        if (key == 5)
+            throw runtime_error("stop");
+    };
+    int caught = 0;
+    try
+    {
+        throwing.forEach(thrower, 2);
+    }
+    catch (const runtime_error &)
+    {
+        caught++;
+    }
+    try
+    {
+        throwingSharded.forEach(thrower, 2);
+    }
+    catch (const runtime_error &)
+    {
+        caught++;
+    }
+    size_t again = 0, shardedAgain = 0;
+    throwing.forEach([&](const int &, const int &)
+                     { again++; });
+    throwingSharded.forEach([&](const int &, const int &)
+                            { shardedAgain++; });
+    cout << "Exceptions caught: " << caught << ", walked again: " << again << " and " << shardedAgain << endl; // 应输出 2, 10 and 10
+
+    // 测试6：遍历期间插入的节点都要跳过，但一步最多看chunkSize * 4个节点，不会在一次持锁中扫完它们
+    KLruCache<int, int> skipping(2000);
+    for (int i = 0; i < 1000; i++)
+        skipping.put(i, i);
+    size_t emitted = 0, steps = 0, emptySteps = 0;
+    {
+        KLruCache<int, int>::WalkGuard walk(skipping, false);
+        for (int i = 1000; i < 2000; i++)
+            skipping.put(i, i); // 插入在链表尾部，遍历开始时已有的1000个元素之后
+        vector<pair<int, int>> chunk;
+        bool more = true;
+        while (more)
+        {
+            chunk.clear();
+            more = skipping.walkStep(8, chunk);
+            emitted += chunk.size();
+            steps++;
+            if (chunk.empty())
+                emptySteps++;
+        }
+    }
+    cout << "Emitted " << emitted << " in " << steps << " steps, steps that only skipped new entries: " << emptySteps << endl; // 应输出 1000 in 157 steps, 32
+
+    return 0;
+}
+
+/*测试结果
+Visited: 99, duplicates: 0
+Key 30 value: 3000
+Key 40 visited: No
+Key 1000 visited: No
+Cache still works: Yes
+Snapshot equals initial contents: Yes
+Sharded snapshot size: 10000, consistent: Yes
+Walked 200000 entries in 80.175 ms, max get latency during walk: 4024.96 us（单核机器上主要是线程调度的时间片，不是持锁时间）
+Exceptions caught: 2, walked again: 10 and 10
+Emitted 1000 in 157 steps, steps that only skipped new entries: 32
+*/
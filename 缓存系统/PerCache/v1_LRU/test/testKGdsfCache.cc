@@ -0,0 +1,83 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "KGdsfCache.h"
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：代价高的元素留下，代价低的被淘汰
+    KGdsfCache<string, string> cache(3);
+    cache.put("cheap1", "a", 50);       // 50微秒
+    cache.put("expensive", "b", 200000); // 200毫秒
+    cache.put("cheap2", "c", 50);
+    cache.put("cheap3", "d", 50); // 淘汰优先级最低的cheap1
+    string value;
+    cout << "cheap1 " << (cache.get("cheap1", value) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "expensive " << (cache.get("expensive", value) ? "exists (as expected)" : "was evicted") << endl;
+    cout << "Inflation L: " << cache.inflation() << endl; // 应输出 50
+
+    // 测试2：size参与优先级和容量，大元素占多份容量
+    KGdsfCache<int, int> sized(10);
+    sized.put(1, 1, 100, 8); // 优先级100*1/8 = 12.5
+    sized.put(2, 2, 100, 1); // 优先级100
+    sized.put(3, 3, 100, 2); // 放不下，淘汰优先级最低的1
+    cout << "Key 1 (large) " << (sized.get(1) ? "exists" : "was evicted (as expected)") << ", used: " << sized.usedCapacity() << endl; // 应输出 used: 3
+    cout << "Oversized put ignored: " << (sized.put(4, 4, 1000, 11), sized.get(4) == 0 ? "Yes" : "No") << endl;
+
+    // 测试3：L的老化，曾经很热但不再访问的元素最终被淘汰
+    KGdsfCache<int, int> aging(2);
+    aging.put(1, 1, 10);
+    for (int i = 0; i < 5; i++)
+        aging.get(1); // 频率6，优先级60
+    for (int i = 100; i < 200; i++)
+        aging.put(i, i, 10); // 新元素不断进来，L不断增长
+    cout << "Old hot key aged out: " << (aging.get(1) == 0 ? "Yes" : "No") << endl; // 应输出 Yes
+
+    // 测试4：和LRU比较未命中的总代价
+    // 2000个key，每5个中有1个代价200000（200毫秒），其余代价50；访问分布偏向小编号的key
+    const int keys = 2000, capacity = 200, ops = 200000;
+    KGdsfCache<int, int> gdsf(capacity);
+    KLruCache<int, int> lru(capacity);
+    double gdsfMissCost = 0, lruMissCost = 0;
+    int gdsfMisses = 0, lruMisses = 0;
+    unsigned seed = 7;
+    for (int i = 0; i < ops; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        double r = ((seed >> 8) % 10000) / 10000.0;
+        int key = static_cast<int>(r * r * keys); // 偏斜的分布
+        double cost = key % 5 == 0 ? 200000 : 50;
+        int v = 0;
+        if (!gdsf.get(key, v))
+        {
+            gdsfMisses++;
+            gdsfMissCost += cost;
+            gdsf.put(key, key, cost);
+        }
+        if (!lru.get(key, v))
+        {
+            lruMisses++;
+            lruMissCost += cost;
+            lru.put(key, key);
+        }
+    }
+    cout << "LRU:  misses " << lruMisses << ", total miss cost " << lruMissCost / 1e6 << " s" << endl;
+    cout << "GDSF: misses " << gdsfMisses << ", total miss cost " << gdsfMissCost / 1e6 << " s" << endl;
+
+    return 0;
+}
+
+/*测试结果
+cheap1 was evicted (as expected)
+expensive exists (as expected)
+Inflation L: 50
+Key 1 (large) was evicted (as expected), used: 3
+Oversized put ignored: Yes
+Old hot key aged out: Yes
+LRU:  misses 162392, total miss cost 6451.91 s
+GDSF: misses 169656, total miss cost 2582.44 s
+*/
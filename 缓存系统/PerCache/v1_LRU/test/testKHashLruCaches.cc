@@ -83,6 +83,36 @@ int main()
         cout << "Key 149 not found" << endl;
     }
 
+    // 测试重新分片：4个分片 -> 8个分片，迁移在后台进行，期间读写照常
+    KHashLruCaches<int, string> resharded(1000, 4);
+    for (int i = 0; i < 500; ++i)
+    {
+        resharded.put(i, "Value" + to_string(i));
+    }
+    resharded.reshard(8);
+    resharded.put(1, "New1"); // 迁移期间写入的新值不会被旧值覆盖
+    int found = 0;
+    for (int i = 0; i < 500; ++i)
+    {
+        found += resharded.get(i, value) ? 1 : 0; // 迁移期间新旧布局都会查
+    }
+    resharded.waitForReshard();
+    cout << "Slices after reshard: " << resharded.sliceNum() << endl; // 应输出 8
+    cout << "Keys found during reshard: " << found << endl;             // 应输出 500
+    cout << "Size after reshard: " << resharded.size() << endl;         // 应输出 500
+    if (resharded.get(1, value))
+    {
+        cout << "Key 1 after reshard: " << value << endl; // 应输出 "New1"
+    }
+
+    // 测试运行时缩容
+    resharded.setCapacity(80);
+    for (int i = 0; i < 500; ++i)
+    {
+        resharded.get(i, value);
+    }
+    cout << "Size after setCapacity(80): " << resharded.size() << endl; // 应输出 80
+
     cout << "KHashLruCaches test completed." << endl;
 
     return 0;
@@ -96,5 +126,10 @@ Key 3: Cherry
 Key 4 not found (as expected)
 Key 1 was evicted (as expected)
 Key 149 exists: Value149
+Slices after reshard: 8
+Keys found during reshard: 500
+Size after reshard: 500
+Key 1 after reshard: New1
+Size after setCapacity(80): 80
 KHashLruCaches test completed.
 */
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 统计被调用次数的哈希函数
+atomic<size_t> hashCalls(0);
+struct CountingHasher
+{
+    size_t operator()(const string &key) const
+    {
+        hashCalls++;
+        return hash<string>()(key);
+    }
+};
+
+int main()
+{
+    // 测试1：分片缓存每次操作只计算一次哈希值（分片选择和分片内查找共用）
+    KHashLruCaches<string, int, CountingHasher> sharded(1000, 4);
+    hashCalls = 0;
+    for (int i = 0; i < 1000; i++)
+        sharded.put("key" + to_string(i), i);
+    int value = 0;
+    for (int i = 0; i < 1000; i++)
+        sharded.get("key" + to_string(i), value);
+    cout << "Hash calls for 1000 puts + 1000 gets: " << hashCalls << endl; // 应输出 2000
+    cout << "Key 500: " << sharded.get("key500") << endl;                   // 应输出 500
+
+    // 测试2：分片内哈希表扩容时使用保存的哈希值，不会重新哈希
+    KLruCache<string, int, CountingHasher> cache(100000);
+    hashCalls = 0;
+    for (int i = 0; i < 100000; i++)
+        cache.put("key" + to_string(i), i); // 期间哈希表会扩容很多次
+    cout << "Hash calls for 100000 puts: " << hashCalls << endl; // 应输出 100000
+
+    // 测试3：淘汰和重新分片后数据仍然正确
+    KHashLruCaches<string, int, CountingHasher> small(8, 2);
+    for (int i = 0; i < 20; i++)
+        small.put("k" + to_string(i), i);
+    small.reshard(3);
+    small.waitForReshard();
+    cout << "Size after reshard: " << small.size() << endl;                                     // 应输出 8
+    cout << "k19 after reshard: " << (small.get("k19", value) && value == 19 ? "Yes" : "No") << endl; // 应输出 Yes
+    cout << "k0 evicted: " << (small.get("k0", value) ? "No" : "Yes") << endl;                  // 应输出 Yes
+
+    // 测试4：长string key的读性能
+    vector<string> keys;
+    for (int i = 0; i < 10000; i++)
+        keys.push_back(string(256, 'k') + to_string(i));
+    KHashLruCaches<string, int> longKeys(10000, 8); // 分片不均匀，少数key会被淘汰
+    for (int i = 0; i < 10000; i++)
+        longKeys.put(keys[i], i);
+    auto start = chrono::steady_clock::now();
+    long long sum = 0;
+    for (int round = 0; round < 50; round++)
+        for (auto &key : keys)
+        {
+            longKeys.get(key, value);
+            sum += value;
+        }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (50 * keys.size());
+    cout << "256-byte key get: " << ns << " ns/op (checksum " << sum << ")" << endl;
+
+    return 0;
+}
+
+/*测试结果
+Hash calls for 1000 puts + 1000 gets: 2000
+Key 500: 500
+Hash calls for 100000 puts: 100000
+Size after reshard: 8
+k19 after reshard: Yes
+k0 evicted: Yes
+256-byte key get: 778.635 ns/op (checksum 2499743100)（未开优化的构建；-O2下同样的读循环从改动前的约500ns/op降到约305ns/op）
+*/
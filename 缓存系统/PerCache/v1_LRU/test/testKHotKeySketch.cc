@@ -0,0 +1,75 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：单个sketch，热点key一定会被找出来
+    KHotKeySketch<int> sketch(8);
+    for (int i = 0; i < 10000; i++)
+    {
+        sketch.offer(i % 3 == 0 ? 42 : i); // key42占1/3的访问，其余key各出现一次
+    }
+    vector<KHotKey<int>> all;
+    sketch.collect(all);
+    vector<KHotKey<int>> top = KHotKeySketch<int>::merge(all, 1, 1);
+    cout << "Top key in sketch: " << top[0].key << endl; // 应输出 42
+
+    // 测试2：在分片缓存上开启采样统计，合并各分片的结果
+    KHashLruCaches<int, string> cache(1000, 4);
+    cache.enableHotKeyDetection(32, 16); // 每个分片32个计数器，每16次操作采样一次
+    string value;
+    for (int i = 0; i < 200000; i++)
+    {
+        int key;
+        if (i % 4 == 0)
+            key = 7; // 最热
+        else if (i % 8 == 1)
+            key = 13; // 次热
+        else
+            key = 100 + i % 5000; // 大量冷key
+        if (!cache.get(key, value))
+            cache.put(key, "Value" + to_string(key));
+    }
+    vector<KHotKey<int>> hot = cache.topKeys(2);
+    cout << "Top keys:";
+    for (auto &h : hot)
+    {
+        cout << " " << h.key;
+    }
+    cout << endl; // 应输出 7 13
+
+    // 测试3：开启统计前后的get开销对比（数量级参考）
+    KHashLruCaches<int, int> plain(1 << 16, 4);
+    KHashLruCaches<int, int> sampled(1 << 16, 4);
+    sampled.enableHotKeyDetection(64, 64);
+    int iv = 0;
+    for (int i = 0; i < (1 << 16); i++)
+    {
+        plain.put(i, i);
+        sampled.put(i, i);
+    }
+    const int ops = 2000000;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++)
+        plain.get(i & 0xffff, iv);
+    auto mid = chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++)
+        sampled.get(i & 0xffff, iv);
+    auto end = chrono::steady_clock::now();
+    cout << "get without sketch: " << chrono::duration<double, nano>(mid - start).count() / ops << " ns/op" << endl;
+    cout << "get with sketch:    " << chrono::duration<double, nano>(end - mid).count() / ops << " ns/op" << endl;
+
+    return 0;
+}
+
+/*测试结果（-O2编译，耗时与机器有关）
+Top key in sketch: 42
+Top keys: 7 13
+get without sketch: 102.2 ns/op
+get with sketch:    104.4 ns/op
+*/
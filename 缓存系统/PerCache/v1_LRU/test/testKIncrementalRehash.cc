@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include "KLruCache.h"
+#include "KIncrementalHashMap.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 插入n个元素，返回"触发扩容的那些插入"中最慢的一次的耗时（微秒）
+/*
+    单核的测试机上任何一次插入都可能被调度出去几毫秒，所以不统计所有插入的最大值，
+    只统计桶数变化（开始扩容）的那些插入：unordered_map在这次插入中重新散列所有元素，渐进式扩容只分配新桶数组。
+*/
+template <typename Insert, typename Buckets>
+double worstGrowthMicros(int n, Insert insert, Buckets buckets)
+{
+    double worst = 0;
+    for (int i = 0; i < n; i++)
+    {
+        size_t before = buckets();
+        auto start = chrono::steady_clock::now();
+        insert(i);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        if (buckets() != before && us > worst)
+            worst = us;
+    }
+    return worst;
+}
+
+struct IntHash
+{
+    size_t operator()(int key) const { return hash<int>()(key); }
+};
+
+int main()
+{
+    // 测试1：渐进式扩容期间查找、删除都正确
+    KIncrementalHashMap<int, int, IntHash, equal_to<int>> map;
+    map.reserve(8);
+    for (int i = 0; i < 100000; i++)
+        map.emplace(i, i * 2);
+    bool allFound = true;
+    for (int i = 0; i < 100000; i++)
+        allFound = allFound && map.find(i) != map.end() && map.find(i)->second == i * 2;
+    for (int i = 0; i < 100000; i += 2)
+        map.erase(i);
+    cout << "All found: " << (allFound ? "Yes" : "No") << ", size after erasing evens: " << map.size()
+         << ", key 3: " << map.find(3)->second << ", key 4 " << (map.find(4) == map.end() ? "erased" : "exists") << endl;
+    cout << "Duplicate emplace rejected: " << (map.emplace(3, 0) ? "No" : "Yes") << endl;
+
+    // 测试2：触发扩容的插入的耗时：unordered_map一次性扩容 vs 渐进式扩容（都从空表开始插入200万个元素，重复3次取最好的一次）
+    const int n = 2000000;
+    double plainWorst = 1e18, incrementalWorst = 1e18;
+    for (int round = 0; round < 3; round++)
+    {
+        unordered_map<int, int> plain;
+        plainWorst = min(plainWorst, worstGrowthMicros(n, [&](int i)
+                                                       { plain.emplace(i, i); },
+                                                       [&]()
+                                                       { return plain.bucket_count(); }));
+        KIncrementalHashMap<int, int, IntHash, equal_to<int>> incremental;
+        incrementalWorst = min(incrementalWorst, worstGrowthMicros(n, [&](int i)
+                                                                   { incremental.emplace(i, i); },
+                                                                   [&]()
+                                                                   { return incremental.bucketCount(); }));
+    }
+    cout << "unordered_map worst growth insert:       " << plainWorst << " us" << endl;
+    cout << "KIncrementalHashMap worst growth insert: " << incrementalWorst << " us" << endl;
+
+    // 测试3：KLruCache按容量预先分配，预热期间索引不扩容；setCapacity调大后渐进式扩容，put都正常完成
+    KLruCache<int, int> cache(n);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        cache.put(i, i);
+    cache.setCapacity(2 * n);
+    for (int i = 0; i < n; i++)
+        cache.put(n + i, i);
+    cout << "KLruCache after growth: size " << cache.size() << ", key 0: " << cache.get(0) << ", key " << 2 * n - 1 << ": " << cache.get(2 * n - 1)
+         << " (" << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms for " << 2 * n << " puts)" << endl;
+    return 0;
+}
+
+/*测试结果（单核机器，KLruCache那一行的总耗时包括调度的影响）
+All found: Yes, size after erasing evens: 50000, key 3: 6, key 4 erased
+Duplicate emplace rejected: Yes
+unordered_map worst growth insert:       49442.9 us
+KIncrementalHashMap worst growth insert: 162.756 us
+KLruCache after growth: size 4000000, key 0: 0, key 3999999: 1999999 (5051.84 ms for 4000000 puts)
+*/
@@ -59,6 +59,25 @@ int main()
         std::cout << "Key 2 has been removed." << std::endl; // 应输出
     }
 
+    // 测试6：运行时缩容，多出来的元素在之后的操作中分批淘汰
+    KLruCache<int, int> big(100);
+    for (int i = 0; i < 100; i++)
+    {
+        big.put(i, i);
+    }
+    big.setCapacity(10); // 只淘汰一小步
+    std::cout << "Size right after setCapacity(10): " << big.size() << std::endl; // 应输出 92
+    for (int i = 0; i < 20; i++)
+    {
+        big.get(99); // 每次操作顺带淘汰最多8个
+    }
+    std::cout << "Size after a few operations: " << big.size() << std::endl; // 应输出 10
+    int iv = 0;
+    if (big.get(99, iv) && !big.get(0, iv))
+    {
+        std::cout << "Most recent keys kept, oldest keys evicted." << std::endl; // 应输出
+    }
+
     return 0;
 }
 
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <string>
+#include <memory_resource>
+#include "KLruCache.h"
+#include "KMemoryBudget.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    const size_t valueSize = 1024;
+    pmr::string bigValue(valueSize, 'x');
+
+    // 测试1：单个KLruCache的实际内存：节点、索引、value在堆上的1KB都计入
+    KCountingResource resource;
+    size_t baseline = 0;
+    {
+        KLruCache<int, pmr::string> cache(1000, &resource);
+        baseline = resource.bytes(); // 按容量预先分配的桶数组
+        for (int i = 0; i < 1000; i++)
+            cache.put(i, bigValue);
+        cout << "Buckets only: " << baseline << " bytes, with 1000 x 1KB values: " << resource.bytes() << " bytes ("
+             << (resource.bytes() - baseline) / 1000 << " bytes per entry)" << endl;
+        for (int i = 0; i < 1000; i++)
+            cache.remove(i);
+        cout << "After removing all: " << resource.bytes() << " bytes (back to buckets only: " << (resource.bytes() == baseline ? "Yes" : "No") << ")" << endl;
+    }
+    cout << "After destruction: " << resource.bytes() << " bytes" << endl; // 应输出 0
+
+    // 测试2：8个分片共享4MB的预算，写入20000个1KB的value（约24MB），总量始终不超过预算
+    KHashLruCaches<int, pmr::string> budgeted(20000, 8, 4 * 1024 * 1024);
+    size_t peak = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        budgeted.put(i, bigValue);
+        peak = max(peak, budgeted.memoryUsed());
+    }
+    size_t sliceSum = 0;
+    for (size_t bytes : budgeted.sliceMemoryUsed())
+        sliceSum += bytes;
+    cout << "Budget " << budgeted.memoryLimit() << " bytes: used " << budgeted.memoryUsed() << ", peak after put " << peak
+         << ", entries kept " << budgeted.size() << endl;
+    cout << "Sum of slice bytes equals total: " << (sliceSum == budgeted.memoryUsed() ? "Yes" : "No") << endl;
+    pmr::string value;
+    cout << "Newest key kept: " << (budgeted.get(19999, value) ? "Yes" : "No")
+         << ", oldest key evicted: " << (budgeted.get(0, value) ? "No" : "Yes") << endl;
+
+    // 测试3：调小预算，立即淘汰到预算以内
+    budgeted.setMemoryLimit(2 * 1024 * 1024);
+    cout << "After setMemoryLimit(2MB): used " << budgeted.memoryUsed() << ", entries kept " << budgeted.size() << endl;
+
+    // 测试4：重新分片期间新旧布局都计入预算
+    budgeted.reshard(4);
+    for (int i = 20000; i < 22000; i++)
+        budgeted.put(i, bigValue);
+    budgeted.waitForReshard();
+    cout << "After reshard to 4 slices: used " << budgeted.memoryUsed() << " <= limit: "
+         << (budgeted.memoryUsed() <= budgeted.memoryLimit() ? "Yes" : "No") << ", entries kept " << budgeted.size() << endl;
+    return 0;
+}
+
+/*测试结果
+Buckets only: 8192 bytes, with 1000 x 1KB values: 1201192 bytes (1193 bytes per entry)
+After removing all: 8192 bytes (back to buckets only: Yes)
+After destruction: 0 bytes
+Budget 4194304 bytes: used 4194272, peak after put 4194272, entries kept 3296
+Sum of slice bytes equals total: Yes
+Newest key kept: Yes, oldest key evicted: Yes
+After setMemoryLimit(2MB): used 2094592, entries kept 1536
+After reshard to 4 slices: used 2094592 <= limit: Yes, entries kept 1536
+*/
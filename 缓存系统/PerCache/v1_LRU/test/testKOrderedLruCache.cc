@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include "KOrderedLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 按时间分桶的key：(用户ID, 时间桶)
+using UserBucket = pair<int, long>;
+
+int main()
+{
+    // 测试1：范围查询"用户X在t1到t2之间的所有缓存项"
+    KOrderedLruCache<UserBucket, string> cache(100);
+    for (int user = 1; user <= 3; user++)
+        for (long t = 100; t <= 500; t += 100)
+            cache.put({user, t}, "u" + to_string(user) + "@" + to_string(t));
+    vector<pair<UserBucket, string>> out;
+    size_t n = cache.rangeGet({2, 200}, {2, 400}, out);
+    cout << "User 2 in [200, 400]: " << n << " entries:"; // 应输出 3个
+    for (auto &entry : out)
+        cout << " " << entry.second;
+    cout << endl;
+
+    // 测试2：范围查询默认不改变新旧，touch = true时改变
+    KOrderedLruCache<int, int> small(4);
+    for (int i = 1; i <= 4; i++)
+        small.put(i, i * 10);
+    vector<pair<int, int>> scanned;
+    small.rangeGet(1, 2, scanned); // 只读，不改变新旧
+    small.put(5, 50);              // 淘汰最久未访问的1
+    cout << "Key 1 after plain scan + put: " << (small.get(1) == 0 ? "evicted (as expected)" : "kept") << endl;
+    scanned.clear();
+    small.rangeGet(2, 3, scanned, true); // 2、3变成最新
+    small.put(6, 60);                    // 淘汰4
+    cout << "Key 2 after touching scan + put: " << (small.get(2) == 20 ? "kept (as expected)" : "evicted") << endl;
+    cout << "Key 4 after touching scan + put: " << (small.get(4) == 0 ? "evicted (as expected)" : "kept") << endl;
+
+    // 测试3：前缀查询
+    KOrderedLruCache<string, int> names(100);
+    names.put("user:1:profile", 1);
+    names.put("user:1:settings", 2);
+    names.put("user:10:profile", 3);
+    names.put("user:2:profile", 4);
+    names.put("user:", 5);
+    vector<pair<string, int>> matched;
+    names.prefixGet("user:1:", matched);
+    cout << "Prefix user:1: ->";
+    for (auto &entry : matched)
+        cout << " " << entry.first;
+    cout << endl; // 应输出 user:1:profile user:1:settings（不包括user:10:profile）
+
+    // 测试4：limit分批查询
+    KOrderedLruCache<int, int> big(1000);
+    for (int i = 0; i < 1000; i++)
+        big.put(i, i);
+    size_t total = 0, batches = 0;
+    int next = 100;
+    while (true)
+    {
+        vector<pair<int, int>> batch;
+        if (big.rangeGet(next, 899, batch, false, 64) == 0)
+            break;
+        total += batch.size();
+        batches++;
+        next = batch.back().first + 1;
+    }
+    cout << "Batched range [100, 899]: " << total << " entries in " << batches << " batches" << endl; // 应输出 800 entries in 13 batches
+
+    // 测试5：删除、更新之后索引和LRU链表保持一致
+    big.remove(500);
+    big.put(501, -1);
+    vector<pair<int, int>> around;
+    big.rangeGet(499, 502, around);
+    cout << "Range [499, 502] after remove/update:";
+    for (auto &entry : around)
+        cout << " " << entry.first << "=" << entry.second;
+    cout << ", size: " << big.size() << endl; // 应输出 499=499 501=-1 502=502, size: 999
+
+    // 测试6：被淘汰的元素正好是新key在有序索引中的后继（"b"最久未访问，"a"插在"b"前面）
+    KOrderedLruCache<string, int> successor(2);
+    successor.put("b", 1);
+    successor.put("c", 2);
+    successor.put("a", 3);
+    vector<pair<string, int>> all;
+    successor.rangeGet("a", "z", all);
+    cout << "After evicting the successor:";
+    for (auto &entry : all)
+        cout << " " << entry.first << "=" << entry.second;
+    cout << endl; // 应输出 a=3 c=2
+    return 0;
+}
+
+/*测试结果
+User 2 in [200, 400]: 3 entries: u2@200 u2@300 u2@400
+Key 1 after plain scan + put: evicted (as expected)
+Key 2 after touching scan + put: kept (as expected)
+Key 4 after touching scan + put: evicted (as expected)
+Prefix user:1: -> user:1:profile user:1:settings
+Batched range [100, 899]: 800 entries in 13 batches
+Range [499, 502] after remove/update: 499=499 501=-1 502=502, size: 999
+After evicting the successor: a=3 c=2
+*/
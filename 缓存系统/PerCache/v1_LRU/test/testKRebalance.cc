@@ -0,0 +1,91 @@
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 倾斜的访问：75%的访问落在3000个key%4==0的key上（都在0号分片），其余25%落在其它分片的600个key上
+// 总容量4000，全局LRU放得下所有3600个key；平均分成4个分片时0号分片只有1000的容量
+struct SkewedWorkload
+{
+    unsigned seed = 2024;
+    int next()
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = seed >> 8;
+        if (r % 4 != 0)
+            return static_cast<int>((r / 4) % 3000) * 4; // 0号分片
+        int other = static_cast<int>((r / 4) % 600);
+        return (other / 3) * 4 + other % 3 + 1;         // 1、2、3号分片，每个200个key
+    }
+};
+
+template <typename Cache>
+double hitRatio(Cache &cache, bool rebalance, int ops)
+{
+    SkewedWorkload workload;
+    int hits = 0, measured = 0, value = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        int key = workload.next();
+        bool hit = cache.get(key, value);
+        if (!hit)
+            cache.put(key, key);
+        if (i >= ops / 2) // 只统计后一半（调配已经稳定）
+        {
+            measured++;
+            hits += hit;
+        }
+        if constexpr (!is_same<Cache, KLruCache<int, int>>::value)
+        {
+            if (rebalance && i % 10000 == 0)
+                cache.rebalance();
+        }
+    }
+    return 100.0 * hits / measured;
+}
+
+int main()
+{
+    const int ops = 1000000;
+    KLruCache<int, int> global(4000);
+    KHashLruCaches<int, int> fixed(4000, 4);
+    KHashLruCaches<int, int> adaptive(4000, 4);
+    adaptive.enableRebalancing(chrono::milliseconds(0)); // 不启动后台线程，测试中每1万次操作手动调配一次
+
+    cout << "Global LRU hit ratio:          " << hitRatio(global, false, ops) << "%" << endl;
+    cout << "Fixed shards hit ratio:        " << hitRatio(fixed, false, ops) << "%" << endl;
+    cout << "Rebalanced shards hit ratio:   " << hitRatio(adaptive, true, ops) << "%" << endl;
+    vector<int> capacities = adaptive.sliceCapacities();
+    cout << "Slice capacities:";
+    for (int capacity : capacities)
+        cout << " " << capacity;
+    cout << " (total " << accumulate(capacities.begin(), capacities.end(), 0) << ")" << endl; // 总和应为4000
+
+    // 后台线程定期调配
+    KHashLruCaches<int, int> background(4000, 4);
+    background.enableRebalancing(chrono::milliseconds(5));
+    SkewedWorkload workload;
+    int value = 0;
+    for (int i = 0; i < ops; i++)
+    {
+        int key = workload.next();
+        if (!background.get(key, value))
+            background.put(key, key);
+    }
+    capacities = background.sliceCapacities();
+    cout << "Background rebalancer moved capacity to slice 0: " << (capacities[0] > 1000 ? "Yes" : "No")
+         << " (total " << accumulate(capacities.begin(), capacities.end(), 0) << ")" << endl; // 应输出 Yes (total 4000)
+
+    return 0;
+}
+
+/*测试结果
+Global LRU hit ratio:          100%
+Fixed shards hit ratio:        49.9616%
+Rebalanced shards hit ratio:   100%
+Slice capacities: 3170 318 256 256 (total 4000)
+Background rebalancer moved capacity to slice 0: Yes (total 4000)
+*/
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include "KShardedCache.h"
+#include "KLruCache.h"
+#include "KSlruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 多线程混合读写，返回耗时（毫秒）
+template <typename Cache>
+double runThreads(Cache &cache, int threadNum, int opsPerThread)
+{
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int t = 0; t < threadNum; t++)
+        threads.emplace_back([&cache, t, opsPerThread]()
+                             {
+                                 unsigned seed = t + 1;
+                                 int value = 0;
+                                 for (int i = 0; i < opsPerThread; i++)
+                                 {
+                                     seed = seed * 1103515245 + 12345;
+                                     int key = (seed >> 8) % 20000;
+                                     if (!cache.get(key, value))
+                                         cache.put(key, key);
+                                 } });
+    for (auto &th : threads)
+        th.join();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// key为负数时put抛出异常的LRU（模拟分配失败、key/value的复制抛出异常）
+class ThrowingLruCache : public KLruCache<int, int>
+{
+public:
+    explicit ThrowingLruCache(int capacity) : KLruCache<int, int>(capacity) {}
+
+    void put(int key, int value) override
+    {
+        if (key < 0)
+            throw runtime_error("put failed");
+        KLruCache<int, int>::put(key, value);
+    }
+};
+
+int main()
+{
+    // 测试1：分片的LRU-K（每个分片：容量250，历史容量100，k=3）
+    KShardedCache<KLruKCache<int, string>> lruk(1000, 4, 100, 3);
+    lruk.put(1, "one"); // 第1次访问：只进入历史
+    string value;
+    cout << "Key 1 on 2nd access: " << (lruk.get(1, value) ? "hit" : "miss (as expected)") << endl;
+    cout << "Key 1 on 3rd access: " << (lruk.get(1, value) ? "hit: " + value : "miss") << endl; // 达到k=3，进入主缓存
+    lruk.withShard(7, [](KLruKCache<int, string> &shard)
+                   { shard.enableNegativeCache(1000); shard.markAbsent(7); });
+    cout << "Key 7 known absent: " << (lruk.withShard(7, [](KLruKCache<int, string> &shard)
+                                                      { return shard.isKnownAbsent(7); })
+                                           ? "Yes"
+                                           : "No")
+         << endl;
+
+    // 测试2：通过KICachePolicy接口使用，分片SLRU
+    KShardedCache<KSlruCache<int, int>> slru(100, 4, 0.8);
+    KICachePolicy<int, int> &policy = slru;
+    for (int i = 0; i < 100; i++)
+        policy.put(i, i * 2);
+    cout << "SLRU key 42: " << policy.get(42) << endl; // 应输出 84
+
+    // 测试3：统计是所有分片之和
+    KShardedStats stats = slru.stats();
+    cout << "SLRU stats: gets " << stats.gets << ", hits " << stats.hits << ", puts " << stats.puts << endl; // 应输出 gets 1, hits 1, puts 100
+    uint64_t perShardPuts = 0;
+    for (int i = 0; i < slru.shardNum(); i++)
+        perShardPuts += slru.shardStats(i).puts;
+    cout << "Sum of shard puts: " << perShardPuts << endl; // 应输出 100
+
+    // 测试4：多线程下单个LRU-K和分片LRU-K
+    const int threadNum = 4, ops = 200000;
+    KShardedCache<KLruKCache<int, int>> single(10000, 1, 5000, 2); // 1个分片 = 一个全局锁
+    KShardedCache<KLruKCache<int, int>> sharded(10000, 16, 500, 2);
+    double singleTime = runThreads(single, threadNum, ops);
+    double shardedTime = runThreads(sharded, threadNum, ops);
+    cout << "LRU-K 1 shard:   " << singleTime << " ms, hit rate " << single.stats().hitRate() << endl;
+    cout << "LRU-K 16 shards: " << shardedTime << " ms, hit rate " << sharded.stats().hitRate() << endl;
+
+    // 测试5：自己加锁的KLruCache用KNoLock
+    KShardedCache<KLruCache<int, int>, KNoLock> lru(10000, 8);
+    cout << "LRU (KNoLock) 8 shards: " << runThreads(lru, threadNum, ops) << " ms, hit rate " << lru.stats().hitRate() << endl;
+
+    // 测试6：策略抛出异常时分片锁也会释放，之后同一个分片上的请求不会死锁
+    KShardedCache<ThrowingLruCache> throwing(100, 1); // 只有一个分片
+    try
+    {
+        throwing.put(-1, 0);
+    }
+    catch (const runtime_error &)
+    {
+        cout << "Policy threw inside the shard lock" << endl;
+    }
+    throwing.put(1, 10); // 修复前这里永远等不到分片锁
+    cout << "Same shard after the exception: key 1 = " << throwing.get(1) << endl; // 应输出 10
+
+    return 0;
+}
+
+/*测试结果（单核机器，多线程看不出分片的加速，只验证正确性）
+Key 1 on 2nd access: miss (as expected)
+Key 1 on 3rd access: hit: one
+Key 7 known absent: Yes
+SLRU key 42: 84
+SLRU stats: gets 1, hits 1, puts 100
+Sum of shard puts: 100
+LRU-K 1 shard:   4161.16 ms, hit rate 0.494509
+LRU-K 16 shards: 4481.17 ms, hit rate 0.495066
+LRU (KNoLock) 8 shards: 1394.18 ms, hit rate 0.495375
+Policy threw inside the shard lock
+Same shard after the exception: key 1 = 10
+*/
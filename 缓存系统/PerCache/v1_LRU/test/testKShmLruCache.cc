@@ -0,0 +1,129 @@
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <sys/wait.h>
+#include <sys/mman.h> //shm_open
+#include <fcntl.h>    //O_CREAT
+#include <unistd.h>
+#include "KShmLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 固定长度的value（共享内存中不能放std::string）
+struct Name
+{
+    char text[24];
+};
+
+static Name makeName(const string &s)
+{
+    Name name{};
+    s.copy(name.text, sizeof(name.text) - 1);
+    return name;
+}
+
+int main()
+{
+    const string shmName = "/percache_test_" + to_string(getpid());
+    KShmLruCache<int, Name>::destroy(shmName);
+
+    // 父进程创建共享内存缓存：容量1000，4个分片
+    KShmLruCache<int, Name> cache(shmName, 1000, 4);
+
+    // 测试1：4个worker进程各自attach同一个缓存，写入自己的key
+    for (int w = 0; w < 4; w++)
+    {
+        if (fork() == 0)
+        {
+            KShmLruCache<int, Name> worker(shmName, 0, 0); // attach已有的缓存，参数被忽略
+            for (int i = 0; i < 100; i++)
+                worker.put(w * 100 + i, makeName("worker" + to_string(w)));
+            _exit(0);
+        }
+    }
+    while (wait(nullptr) > 0)
+    {
+    }
+    cout << "Size after 4 workers: " << cache.size() << endl;    // 应输出 400
+    cout << "Key 250 written by: " << cache.get(250).text << endl; // 应输出 worker2
+
+    // 测试2：LRU淘汰在共享内存中同样生效
+    for (int i = 1000; i < 3000; i++)
+        cache.put(i, makeName("fill"));
+    Name name;
+    cout << "Key 0 " << (cache.get(0, name) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "Size is capped: " << (cache.size() <= 1000 ? "Yes" : "No") << endl;
+
+    // 测试3：一个worker在写入过程中被kill -9，缓存仍然可用
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        KShmLruCache<int, Name> worker(shmName, 0, 0);
+        for (int i = 0;; i++)
+            worker.put(i % 5000, makeName("crash"));
+    }
+    usleep(50000);
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    cache.put(42, makeName("after crash"));
+    cout << "Key 42 after worker crash: " << cache.get(42).text << endl; // 应输出 after crash
+    cache.size(); // 依次锁一遍所有分片：被kill的worker如果正持有某个分片的锁，在这里恢复
+
+    // 测试4：一个worker持有分片锁时退出，下一个加锁的进程得到EOWNERDEAD并重置这个分片
+    for (int i = 0; i < 1000; i++)
+        cache.put(i, makeName("v" + to_string(i)));
+    uint32_t recoveredBefore = cache.recoveredSlices();
+    pid = fork();
+    if (pid == 0)
+    {
+        KShmLruCache<int, Name> worker(shmName, 0, 0);
+        worker.update(7, [](Name &)
+                      { _exit(0); }); // 在分片锁内退出，锁没有释放
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    cout << "Worker exited inside update: " << (WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "Yes" : "No") << endl;
+    size_t sizeAfter = cache.size();
+    cout << "Recovered slices: +" << cache.recoveredSlices() - recoveredBefore
+         << ", key 7 dropped with its slice: " << (cache.get(7, name) ? "No" : "Yes")
+         << ", entries left in other slices: " << sizeAfter << endl; // 应输出 +1, Yes, 大约750
+    cache.put(7, makeName("seven"));
+    bool updated = cache.update(7, [](Name &value)
+                                { value.text[0] = 'S'; });
+    cout << "Recovered slice usable: update " << (updated ? "found" : "missed") << " key 7, now " << cache.get(7).text << endl; // 应输出 found, Seven
+
+    // 测试5：创建者在初始化完成之前崩溃，attach等待超时后抛出异常，而不是一直等下去
+    const string brokenName = shmName + "_broken";
+    int fd = shm_open(brokenName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0 && ftruncate(fd, 4096) == 0) // 只ftruncate，不初始化，ready一直是0
+    {
+        close(fd);
+        try
+        {
+            KShmLruCache<int, Name> attach(brokenName, 0, 0, chrono::milliseconds(100));
+            cout << "Attach to a never-initialized segment: succeeded (unexpected)" << endl;
+        }
+        catch (const runtime_error &)
+        {
+            cout << "Attach to a never-initialized segment: timed out (as expected)" << endl;
+        }
+    }
+    KShmLruCache<int, Name>::destroy(brokenName);
+
+    KShmLruCache<int, Name>::destroy(shmName);
+    return 0;
+}
+
+/*测试结果
+Size after 4 workers: 400
+Key 250 written by: worker2
+Key 0 was evicted (as expected)
+Size is capped: Yes
+Key 42 after worker crash: after crash
+Worker exited inside update: Yes
+Recovered slices: +1, key 7 dropped with its slice: Yes, entries left in other slices: 750
+Recovered slice usable: update found key 7, now Seven
+Attach to a never-initialized segment: timed out (as expected)
+*/
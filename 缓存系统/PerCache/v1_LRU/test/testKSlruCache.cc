@@ -0,0 +1,58 @@
+#include <iostream>
+#include <string>
+#include "KSlruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 创建一个容量为5的SLRU缓存，保护段占60%（3个）
+    KSlruCache<int, string> cache(5, 0.6);
+
+    // 测试1：新key先进入试用段
+    cache.put(1, "One");
+    cache.put(2, "Two");
+    cache.put(3, "Three");
+    cout << "Probation: " << cache.probationSize() << ", Protected: " << cache.protectedSize() << endl; // 应输出 3, 0
+
+    // 测试2：命中后晋升到保护段
+    string value;
+    cache.get(1, value);
+    cache.get(2, value);
+    cache.get(3, value);
+    cout << "Probation: " << cache.probationSize() << ", Protected: " << cache.protectedSize() << endl; // 应输出 0, 3
+
+    // 测试3：一次性扫描只会在试用段轮转，不会淘汰保护段中的热点数据
+    for (int i = 100; i < 120; i++)
+    {
+        cache.put(i, "Scan" + to_string(i));
+    }
+    bool hotKept = cache.get(1, value) && cache.get(2, value) && cache.get(3, value);
+    cout << "Hot keys survive scan: " << (hotKept ? "Yes (as expected)" : "No") << endl;
+    cout << "Scan key 100 " << (cache.get(100, value) ? "exists" : "was evicted (as expected)") << endl;
+
+    // 测试4：保护段溢出时，最久未使用的节点降级回试用段
+    cache.get(119, value); // 119晋升，保护段最久未使用的key1被降级
+    cout << "Probation: " << cache.probationSize() << ", Protected: " << cache.protectedSize() << endl; // 应输出 2, 3
+    cout << "Demoted key 1 still cached: " << (cache.get(1, value) ? value : "No") << endl;         // 应输出 One
+
+    // 测试5：更新和删除
+    cache.put(2, "Two Updated");
+    cout << "Key 2 updated: " << cache.get(2) << endl; // 应输出 Two Updated
+    cache.remove(2);
+    cout << "Key 2 " << (cache.get(2, value) ? "exists" : "has been removed.") << endl;
+
+    return 0;
+}
+
+/*测试结果
+Probation: 3, Protected: 0
+Probation: 0, Protected: 3
+Hot keys survive scan: Yes (as expected)
+Scan key 100 was evicted (as expected)
+Probation: 2, Protected: 3
+Demoted key 1 still cached: One
+Key 2 updated: Two Updated
+Key 2 has been removed.
+*/
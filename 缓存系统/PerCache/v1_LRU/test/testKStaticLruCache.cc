@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include "KStaticLruCache.h"
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 编译期求值：容量4，插入5个元素后最久未使用的1被淘汰
+constexpr int compileTimeCheck()
+{
+    KStaticLruCache<int, int, 4> cache;
+    for (int i = 1; i <= 5; i++)
+        cache.put(i, i * 10);
+    int value = 0;
+    return cache.get(1, value) ? -1 : cache.get(5);
+}
+static_assert(compileTimeCheck() == 50, "KStaticLruCache should work at compile time");
+
+int main()
+{
+    // 测试1：线性扫描（N <= 16）
+    KStaticLruCache<int, string, 3> small;
+    small.put(1, "one");
+    small.put(2, "two");
+    small.put(3, "three");
+    string value;
+    small.get(1, value);    // 1变成最新的
+    small.put(4, "four");   // 淘汰2
+    cout << "Key 2 " << (small.get(2, value) ? "exists" : "was evicted (as expected)") << endl;
+    cout << "Key 1: " << small.get(1) << endl; // 应输出 one
+    small.remove(1);
+    small.put(5, "five");
+    cout << "Size: " << small.size() << ", key 3: " << small.get(3) << ", key 5: " << small.get(5) << endl; // 应输出 Size: 3, key 3: three, key 5: five
+
+    // 测试2：哈希索引（N > 16），和KLruCache对比随机操作的结果
+    KStaticLruCache<int, int, 64> indexed;
+    KLruCache<int, int> reference(64);
+    unsigned seed = 12345;
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = (seed >> 8) % 200;
+        int op = (seed >> 20) % 10;
+        if (op < 5)
+        {
+            indexed.put(key, i);
+            reference.put(key, i);
+        }
+        else if (op < 9)
+        {
+            int a = -1, b = -1;
+            bool foundA = indexed.get(key, a);
+            bool foundB = reference.get(key, b);
+            if (foundA != foundB || a != b)
+                mismatches++;
+        }
+        else
+        {
+            indexed.remove(key);
+            reference.remove(key);
+        }
+    }
+    cout << "Mismatches against KLruCache: " << mismatches << ", sizes: " << indexed.size() << " / " << reference.size() << endl; // 应输出 0，两个size相同
+
+    // 测试3：创建大量小缓存的开销
+    const int count = 10000;
+    auto start = chrono::steady_clock::now();
+    {
+        vector<unique_ptr<KLruCache<int, int>>> caches;
+        for (int i = 0; i < count; i++)
+        {
+            caches.emplace_back(new KLruCache<int, int>(8));
+            for (int k = 0; k < 8; k++)
+                caches.back()->put(k, k);
+        }
+    }
+    double heapTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    {
+        vector<KStaticLruCache<int, int, 8>> caches(count);
+        for (auto &cache : caches)
+            for (int k = 0; k < 8; k++)
+                cache.put(k, k);
+    }
+    double staticTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    cout << "sizeof(KStaticLruCache<int, int, 8>): " << sizeof(KStaticLruCache<int, int, 8>) << " bytes" << endl; // 应输出 120
+    cout << "10000 caches x 8 puts: KLruCache " << heapTime << " us, KStaticLruCache " << staticTime << " us" << endl;
+
+    return 0;
+}
+
+/*测试结果
+Key 2 was evicted (as expected)
+Key 1: one
+Size: 3, key 3: three, key 5: five
+Mismatches against KLruCache: 0, sizes: 64 / 64
+sizeof(KStaticLruCache<int, int, 8>): 120 bytes
+10000 caches x 8 puts: KLruCache 134851 us, KStaticLruCache 17630.9 us
+*/
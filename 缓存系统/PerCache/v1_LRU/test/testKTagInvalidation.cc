@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "KLruCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+int main()
+{
+    // 测试1：按标签删除
+    KLruCache<int, string> cache(100);
+    for (int i = 0; i < 30; i++)
+        cache.put(i, "Value" + to_string(i), i % 3); // 标签0、1、2各10个
+    cache.put(100, "untagged");
+    cout << "Removed with tag 1: " << cache.invalidateTag(1) << endl; // 应输出 10
+    string value;
+    cout << "Key 4 " << (cache.get(4, value) ? "exists" : "was invalidated (as expected)") << endl;
+    cout << "Key 3 " << (cache.get(3, value) ? "exists (as expected)" : "was invalidated") << endl;
+    cout << "Size: " << cache.size() << endl; // 应输出 21
+
+    // 测试2：改标签、删除、淘汰之后标签索引保持正确
+    cache.put(3, "retagged", 2);  // 3从标签0改成标签2
+    cache.put(6, "keeps tag 0");  // 不带标签的put保留原来的标签0
+    cache.remove(9);              // 删除的元素不会再被invalidateTag统计
+    cout << "Removed with tag 0: " << cache.invalidateTag(0) << endl; // 应输出 8（0、6、12、15、18、21、24、27）
+    KLruCache<int, int> small(5);
+    for (int i = 0; i < 10; i++)
+        small.put(i, i, 7); // 前5个被淘汰
+    cout << "Removed after eviction: " << small.invalidateTag(7) << ", size: " << small.size() << endl; // 应输出 5, size: 0
+    cout << "Unknown tag: " << small.invalidateTag(42) << endl;                                           // 应输出 0
+
+    // 测试3：分片缓存，分批释放锁，重新分片时标签跟着迁移
+    KHashLruCaches<int, int> sharded(10000, 4);
+    for (int i = 0; i < 6000; i++)
+        sharded.put(i, i, i < 3000 ? 1 : 2);
+    sharded.reshard(6);
+    sharded.waitForReshard();
+    cout << "Sharded removed with tag 1: " << sharded.invalidateTag(1, 64) << ", size: " << sharded.size() << endl; // 应输出 3000, size: 3000
+
+    // 测试4：开销只和带这个标签的元素个数有关
+    KLruCache<int, int> big(1000000);
+    for (int i = 0; i < 1000000; i++)
+        big.put(i, i, i % 10000 == 0 ? 1 : 2); // 标签1只有100个元素
+    auto start = chrono::steady_clock::now();
+    size_t removed = big.invalidateTag(1);
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    cout << "Invalidated " << removed << " of 1000000 entries in " << us << " us" << endl;
+
+    return 0;
+}
+
+/*测试结果
+Removed with tag 1: 10
+Key 4 was invalidated (as expected)
+Key 3 exists (as expected)
+Size: 21
+Removed with tag 0: 8
+Removed after eviction: 5, size: 0
+Unknown tag: 0
+Sharded removed with tag 1: 3000, size: 3000
+Invalidated 100 of 1000000 entries in 222.413 us
+*/
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <atomic>
+#include "KWriteBackCache.h"
+
+using namespace std;
+using namespace PerCache;
+
+// 内存中的后端存储：read复制出值以后调用duringRead，模拟"读后端期间有其他请求"
+template <typename Value>
+class SlowStore : public KBackingStore<string, Value>
+{
+public:
+    map<string, Value> data;
+    function<void()> duringRead;
+
+    bool read(const string &key, Value &value) override
+    {
+        auto it = data.find(key);
+        if (it == data.end())
+            return false;
+        value = it->second;
+        if (duringRead)
+        {
+            auto hook = move(duringRead); // 只触发一次
+            duringRead = nullptr;
+            hook();
+        }
+        return true;
+    }
+
+    void writeBatch(const vector<pair<string, Value>> &batch) override
+    {
+        for (auto &entry : batch)
+            data[entry.first] = entry.second;
+    }
+};
+
+// 复制构造时可以暂停一次的value：put中"写_dirty"之后、"写缓存"复制参数时暂停，让另一个线程的put插进来
+struct PausingValue
+{
+    string text;
+    static atomic<bool> pauseOnCopy;
+
+    PausingValue(const string &t = "") : text(t) {}
+    PausingValue(const PausingValue &other) : text(other.text)
+    {
+        if (pauseOnCopy.exchange(false))
+            this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    PausingValue &operator=(const PausingValue &) = default;
+};
+atomic<bool> PausingValue::pauseOnCopy(false);
+
+int main()
+{
+    const string path = "/tmp/percache_writeback_test.log";
+    remove(path.c_str());
+
+    // 测试1：合并写——100个key各更新100次，一个刷写间隔内只写回一批
+    auto store = make_shared<KFileBackingStore<string, string>>(path);
+    {
+        KWriteBackCache<string, string> cache(1000, store, chrono::milliseconds(200));
+        for (int round = 0; round < 100; round++)
+            for (int i = 0; i < 100; i++)
+                cache.put("key" + to_string(i), "v" + to_string(round));
+        cout << "Dirty keys before flush: " << cache.dirtyCount() << endl; // 应输出 100
+        cache.flush();
+        cout << "Updates: 10000, store batches: " << store->batchCount() << ", records: " << store->recordCount() << endl; // 应输出 batches: 1, records: 100
+
+        // 测试2：后台线程定期写回
+        cache.put("key0", "latest");
+        this_thread::sleep_for(chrono::milliseconds(500));
+        string value;
+        cout << "Background flush wrote key0: " << (store->read("key0", value) && value == "latest" ? "Yes" : "No") << endl; // 应输出 Yes
+    }
+
+    // 测试3：淘汰脏数据之前先写回
+    {
+        auto small = make_shared<KFileBackingStore<string, string>>(path);
+        KWriteBackCache<string, string> cache(2, small, chrono::seconds(60)); // 刷写间隔很长，只能靠淘汰触发写回
+        cache.put("a", "1");
+        cache.put("b", "2");
+        cache.put("c", "3"); // 淘汰a，a先写回
+        string value;
+        cout << "Evicted dirty key written back: " << (small->read("a", value) && value == "1" ? "Yes" : "No") << endl; // 应输出 Yes
+        cout << "Store batches after eviction: " << small->batchCount() << endl;                                     // 应输出 1
+        cout << "Evicted key still readable through cache: " << cache.get("a") << endl;                              // 应输出 1（从后端读回，又淘汰并写回了脏的b）
+    } // 析构时写回剩下的脏数据
+
+    // 测试4：重新打开文件，数据都在
+    KFileBackingStore<string, string> reopened(path);
+    string value;
+    cout << "After reopen: key0 = " << (reopened.read("key0", value) ? value : "missing")
+         << ", key99 = " << (reopened.read("key99", value) ? value : "missing")
+         << ", c = " << (reopened.read("c", value) ? value : "missing") << endl; // 应输出 key0 = latest, key99 = v99, c = 3
+
+    // 测试5：未命中时从后端存储读
+    {
+        auto backing = make_shared<KFileBackingStore<string, string>>(path);
+        KWriteBackCache<string, string> cache(10, backing);
+        cout << "Read-through miss: key42 = " << cache.get("key42") << endl; // 应输出 v99
+    }
+    remove(path.c_str());
+
+    // 测试6：get读后端期间，同一个key被put、淘汰并写回，读到的旧值不能留在缓存里
+    {
+        auto slow = make_shared<SlowStore<string>>();
+        slow->data["k"] = "v0";
+        KWriteBackCache<string, string> cache(2, slow, chrono::seconds(60));
+        slow->duringRead = [&]()
+        {
+            cache.put("k", "v1");
+            cache.put("x", "x");
+            cache.put("y", "y"); // 淘汰k，v1写回后端
+        };
+        string first = cache.get("k"); // 后端读到v0时，v1已经写回
+        cout << "Racing get returned: " << first << ", store has: " << slow->data["k"]
+             << ", next get: " << cache.get("k") << endl; // 应输出 v0, v1, v1（修复前下次get得到缓存中的v0）
+    }
+
+    // 测试7：两个线程并发put同一个key，缓存中的值和最终写回后端的值相同
+    {
+        auto pausing = make_shared<SlowStore<PausingValue>>();
+        KWriteBackCache<string, PausingValue> cache(10, pausing, chrono::seconds(60));
+        thread first([&]()
+                     {
+                         PausingValue::pauseOnCopy = true;
+                         cache.put("k", PausingValue("first")); // 写完_dirty，复制参数写缓存时暂停100ms
+                     });
+        this_thread::sleep_for(chrono::milliseconds(20));
+        thread second([&]()
+                      { cache.put("k", PausingValue("second")); });
+        first.join();
+        second.join();
+        cache.flush();
+        cout << "Concurrent puts: cache has " << cache.get("k").text << ", store has " << pausing->data["k"].text
+             << endl; // 应输出两个相同的值（修复前：cache has first, store has second）
+    }
+    return 0;
+}
+
+/*测试结果
+Dirty keys before flush: 100
+Updates: 10000, store batches: 1, records: 100
+Background flush wrote key0: Yes
+Evicted dirty key written back: Yes
+Store batches after eviction: 1
+Evicted key still readable through cache: 1
+After reopen: key0 = latest, key99 = v99, c = 3
+Read-through miss: key42 = v99
+Racing get returned: v0, store has: v1, next get: v1
+Concurrent puts: cache has second, store has second
+*/